@@ -0,0 +1,174 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "bitboard.h"
+
+#include <cmath>
+#include <iostream>
+
+#include "bitboard_kernel.h"
+
+// vertical mirror -> rows are the bytes of the bitboard
+static uint64_t mirror(uint64_t b) { return __builtin_bswap64(b); }
+
+// PositionBatch class
+int bitboard::PositionBatch::add(const game::Board *board, piece::PieceColor to_move) {
+  if (board->length() != 8 || board->width() != 8 || !to_move.isColored()) {
+    DEBUG_ASSERT
+    return -1;
+  }
+
+  uint64_t sets[SET_COUNT] = {};
+  board->forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+    uint64_t bit = 1ULL << (r * 8 + c);
+    sets[piece->color() == to_move ? OWN: ENEMY] |= bit;
+
+    switch (piece->type()) {
+      case piece::PieceType::KING:
+        sets[KINGS] |= bit;
+        break;
+      case piece::PieceType::QUEEN:
+        sets[QUEENS] |= bit;
+        break;
+      case piece::PieceType::ROOK:
+        sets[ROOKS] |= bit;
+        break;
+      case piece::PieceType::KNIGHT:
+        sets[KNIGHTS] |= bit;
+        break;
+      case piece::PieceType::BISHOP:
+        sets[BISHOPS] |= bit;
+        break;
+      case piece::PieceType::PAWN:
+        sets[PAWNS] |= bit;
+        break;
+      default:
+        DEBUG_ASSERT
+    }
+
+    // |code| = (type value + flag * value space) -> see piece::PieceType::value()
+    double code = std::abs(piece->code());
+    if (code > piece->type().value() + piece::PieceType::PIECE_TYPE_VALUE_SPACE / 2)
+      sets[FLAGS] |= bit;
+  });
+
+  bool is_mirrored = to_move.isBlack();
+  for (int set = 0; set < SET_COUNT; ++set)
+    _bitboards[set].push_back(is_mirrored ? mirror(sets[set]): sets[set]);
+  _mirrored.push_back(is_mirrored);
+
+  return size() - 1;
+}
+
+void bitboard::PositionBatch::reserve(int count) {
+  for (auto &set: _bitboards)
+    set.reserve(count);
+  _mirrored.reserve(count);
+}
+
+void bitboard::PositionBatch::clear() {
+  for (auto &set: _bitboards)
+    set.clear();
+  _mirrored.clear();
+}
+
+// BatchResult class
+void bitboard::BatchResult::resize(int size) {
+  attacked.resize(size);
+  in_check.resize(size);
+  legal_moves.resize(size);
+}
+
+// analysis
+bool bitboard::hasAVX2() {
+#if defined(__x86_64__) || defined(__i386__)
+  static bool supported = hasAVX2Kernel() && __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+void bitboard::analyze(const PositionBatch &batch, BatchResult *result, bool allow_simd) {
+  if (result == nullptr) {
+    DEBUG_ASSERT
+    return;
+  }
+
+  int size = batch.size();
+  result->resize(size);
+
+  int done = allow_simd && hasAVX2() ? analyze_avx2(batch, result): 0;
+  for (int i = done; i < size; ++i)
+    analyze_lanes<ScalarLanes>(batch, i, result);
+
+  // attack maps back to the board's orientation
+  for (int i = 0; i < size; ++i)
+    if (batch.mirrored(i))
+      result->attacked[i] = mirror(result->attacked[i]);
+}
+
+int bitboard::verify(const PositionBatch &batch, const std::vector<game::Board *> &boards) {
+  if ((int) boards.size() != batch.size()) {
+    DEBUG_ASSERT
+    return batch.size();
+  }
+
+  BatchResult scalar, simd;
+  analyze(batch, &scalar, false);
+  analyze(batch, &simd, true); // same as scalar w/o AVX2
+
+  int mismatches = 0;
+  std::vector<game::Move> moves;
+  for (int i = 0; i < batch.size(); ++i) {
+    game::Board *board = boards[i];
+    piece::PieceColor to_move = batch.mirrored(i) ? piece::PieceColor::BLACK: piece::PieceColor::WHITE;
+
+    moves.clear();
+    board->getPossibleMoves(to_move.isWhite() ? &moves: nullptr, to_move.isBlack() ? &moves: nullptr);
+
+    // a square is attacked if an enemy piece other than one standing on it hits it
+    uint64_t attacked = 0;
+    for (int square = 0; square < 64; ++square) {
+      piece::Piece *piece = board->getPiece(square / 8, square % 8);
+      int self = piece->type().isKing() && piece->color() == !to_move; // an enemy king counts its own square
+      if (board->getPositionThreats(square / 8, square % 8, to_move) > self)
+        attacked |= 1ULL << (unsigned) square;
+    }
+
+    bool in_check = !board->isKingSafe(to_move);
+    bool matches = scalar.legal_moves[i] == moves.size() && (bool) scalar.in_check[i] == in_check &&
+                   scalar.attacked[i] == attacked && simd.legal_moves[i] == scalar.legal_moves[i] &&
+                   simd.in_check[i] == scalar.in_check[i] && simd.attacked[i] == scalar.attacked[i];
+    if (matches)
+      continue;
+
+    if (mismatches++ < 3)
+      std::cerr << "bitboard::verify: " << board->toFEN(to_move) << " -> legal moves " << moves.size() << " (scalar "
+                << scalar.legal_moves[i] << ", simd " << simd.legal_moves[i] << "), check " << in_check
+                << " (scalar " << (int) scalar.in_check[i] << ", simd " << (int) simd.in_check[i] << ")" << std::endl;
+  }
+
+  return mismatches;
+}
@@ -0,0 +1,42 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_CHESS_BITBOARD_FWD_H_
+#define CHESS_AI_CHESS_BITBOARD_FWD_H_
+
+// The "bitboard" namespace is for bulk position analysis on 64-bit square sets:
+//   - PositionBatch, BatchResult classes
+//   - analyze(...) for attack maps, check status && legal move counts of a whole batch at once
+//   - verify(...) to check the kernels against game::Board
+namespace bitboard {
+
+// Many positions stored as structure-of-arrays bitboards (one array per piece set)
+class PositionBatch;
+
+// Per-position output of bitboard::analyze(...)
+class BatchResult;
+
+}
+
+#endif // CHESS_AI_CHESS_BITBOARD_FWD_H_
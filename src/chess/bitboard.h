@@ -0,0 +1,95 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_CHESS_BITBOARD_H_
+#define CHESS_AI_CHESS_BITBOARD_H_
+
+#include "bitboard.fwd.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+namespace bitboard {
+
+// The PositionBatch class: See bitboard.fwd.h
+// Square (r, c) is bit r * 8 + c, and every set is stored from the view of the side to move:
+//   - OWN/ENEMY split the pieces by color, FLAGS marks moved kings/rooks && pawns that just moved 2 squares
+//   - black-to-move positions are mirrored vertically, so the side to move always plays "up" the board
+class PositionBatch {
+  public:
+    enum Set {
+      OWN, ENEMY, PAWNS, KNIGHTS, BISHOPS, ROOKS, QUEENS, KINGS, FLAGS, SET_COUNT
+    };
+
+    PositionBatch() = default;
+    PositionBatch(const PositionBatch &pb) = delete;
+    PositionBatch &operator=(const PositionBatch &pb) = delete;
+
+    ~PositionBatch() = default;
+
+    // adds the board w/ to_move as the side to move -> returns the position's index (-1 if not 8x8)
+    int add(const game::Board *board, piece::PieceColor to_move);
+    void reserve(int count);
+    void clear();
+
+    [[nodiscard]] inline int size() const { return (int) _mirrored.size(); }
+    [[nodiscard]] inline const uint64_t *bitboards(Set set) const { return _bitboards[set].data(); }
+    [[nodiscard]] inline bool mirrored(int index) const { return _mirrored[index]; }
+
+  private:
+    std::vector<uint64_t> _bitboards[SET_COUNT];
+    std::vector<bool> _mirrored;
+};
+
+// The BatchResult class: See bitboard.fwd.h
+class BatchResult {
+  public:
+    std::vector<uint64_t> attacked;   // squares attacked by the side not to move (in the board's orientation)
+    std::vector<uint8_t> in_check;    // 1 iff the side to move is in check
+    std::vector<uint16_t> legal_moves; // same count as game::Board::getPossibleMoves(...) (promotions count 4x)
+
+    void resize(int size);
+};
+
+// analyzes every position in the batch -> AVX2 (4 positions per instruction) when the cpu supports it
+void analyze(const PositionBatch &batch, BatchResult *result, bool allow_simd = true);
+
+// self-check over a position set (boards[i] is position i of the batch): the scalar && AVX2 (if supported) kernels
+// must agree w/ each other && w/ game::Board (getPossibleMoves, isKingSafe, getPositionThreats)
+// -> returns the number of positions where anything disagrees (the first few are printed to std::cerr)
+int verify(const PositionBatch &batch, const std::vector<game::Board *> &boards);
+
+// true iff the AVX2 kernel was compiled in && the cpu running the program supports it
+bool hasAVX2();
+
+// true iff the AVX2 kernel was compiled in (see CMakeLists.txt)
+bool hasAVX2Kernel();
+// analyzes the largest multiple of 4 positions w/ the AVX2 kernel -> returns how many were done
+int analyze_avx2(const PositionBatch &batch, BatchResult *result);
+
+}
+
+#endif // CHESS_AI_CHESS_BITBOARD_H_
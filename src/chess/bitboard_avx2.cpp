@@ -0,0 +1,89 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+// Built w/ -mavx2 when the compiler supports it (see CMakeLists.txt)
+// Nothing in here may run unless bitboard::hasAVX2() is true
+#include "bitboard.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "bitboard_kernel.h"
+
+namespace {
+
+// The AVX2 lanes class: 4 positions at a time, one per 64-bit lane
+class Avx2Lanes {
+  public:
+    constexpr static int LANES = 4;
+    __m256i v;
+
+    static inline Avx2Lanes all(uint64_t x) { return {_mm256_set1_epi64x((long long) x)}; }
+    static inline Avx2Lanes load(const uint64_t *p) { return {_mm256_loadu_si256((const __m256i *) p)}; }
+    inline void store(uint64_t *p) const { _mm256_storeu_si256((__m256i *) p, v); }
+};
+
+inline Avx2Lanes operator&(Avx2Lanes a, Avx2Lanes b) { return {_mm256_and_si256(a.v, b.v)}; }
+inline Avx2Lanes operator|(Avx2Lanes a, Avx2Lanes b) { return {_mm256_or_si256(a.v, b.v)}; }
+inline Avx2Lanes operator^(Avx2Lanes a, Avx2Lanes b) { return {_mm256_xor_si256(a.v, b.v)}; }
+inline Avx2Lanes operator~(Avx2Lanes a) { return {_mm256_xor_si256(a.v, _mm256_set1_epi64x(-1))}; }
+inline Avx2Lanes operator+(Avx2Lanes a, Avx2Lanes b) { return {_mm256_add_epi64(a.v, b.v)}; }
+inline Avx2Lanes operator-(Avx2Lanes a, Avx2Lanes b) { return {_mm256_sub_epi64(a.v, b.v)}; }
+template<int N>
+inline Avx2Lanes shl(Avx2Lanes a) { return {_mm256_slli_epi64(a.v, N)}; }
+template<int N>
+inline Avx2Lanes shr(Avx2Lanes a) { return {_mm256_srli_epi64(a.v, N)}; }
+inline Avx2Lanes nonzero(Avx2Lanes a) {
+  return ~Avx2Lanes{_mm256_cmpeq_epi64(a.v, _mm256_setzero_si256())};
+}
+// nibble lookup popcount, summed per 64-bit lane
+inline Avx2Lanes popcount(Avx2Lanes a) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+  __m256i low = _mm256_and_si256(a.v, low_nibbles);
+  __m256i high = _mm256_and_si256(_mm256_srli_epi16(a.v, 4), low_nibbles);
+  __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+  return {_mm256_sad_epu8(counts, _mm256_setzero_si256())};
+}
+
+}
+
+bool bitboard::hasAVX2Kernel() { return true; }
+
+int bitboard::analyze_avx2(const PositionBatch &batch, BatchResult *result) {
+  int count = batch.size() / Avx2Lanes::LANES * Avx2Lanes::LANES;
+  for (int i = 0; i < count; i += Avx2Lanes::LANES)
+    analyze_lanes<Avx2Lanes>(batch, i, result);
+  return count;
+}
+
+#else
+
+bool bitboard::hasAVX2Kernel() { return false; }
+
+int bitboard::analyze_avx2(const PositionBatch &batch, BatchResult *result) { return 0; }
+
+#endif
@@ -0,0 +1,340 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_CHESS_BITBOARD_KERNEL_H_
+#define CHESS_AI_CHESS_BITBOARD_KERNEL_H_
+
+#include <cstdint>
+
+#include "bitboard.h"
+
+// Only included by bitboard.cpp && bitboard_avx2.cpp
+// The kernel is written once against a "lanes" type (V) that holds one bitboard per position:
+//   - V::LANES, V::all(x), V::load(p), v.store(p)
+//   - operators & | ^ ~ + -, shl<N>(v), shr<N>(v), nonzero(v) (all ones iff lane != 0), popcount(v)
+// Everything lives in an unnamed namespace, so each TU gets its own copy compiled w/ its own flags
+namespace {
+
+// The scalar lanes class: 1 position at a time
+class ScalarLanes {
+  public:
+    constexpr static int LANES = 1;
+    uint64_t v;
+
+    static inline ScalarLanes all(uint64_t x) { return {x}; }
+    static inline ScalarLanes load(const uint64_t *p) { return {*p}; }
+    inline void store(uint64_t *p) const { *p = v; }
+};
+
+inline ScalarLanes operator&(ScalarLanes a, ScalarLanes b) { return {a.v & b.v}; }
+inline ScalarLanes operator|(ScalarLanes a, ScalarLanes b) { return {a.v | b.v}; }
+inline ScalarLanes operator^(ScalarLanes a, ScalarLanes b) { return {a.v ^ b.v}; }
+inline ScalarLanes operator~(ScalarLanes a) { return {~a.v}; }
+inline ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return {a.v + b.v}; }
+inline ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return {a.v - b.v}; }
+template<int N>
+inline ScalarLanes shl(ScalarLanes a) { return {a.v << N}; }
+template<int N>
+inline ScalarLanes shr(ScalarLanes a) { return {a.v >> N}; }
+inline ScalarLanes nonzero(ScalarLanes a) { return {a.v != 0 ? ~0ULL: 0ULL}; }
+inline ScalarLanes popcount(ScalarLanes a) { return {(uint64_t) __builtin_popcountll(a.v)}; }
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL, FILE_B = FILE_A << 1;
+constexpr uint64_t FILE_H = FILE_A << 7, FILE_G = FILE_A << 6;
+constexpr uint64_t ROW_0 = 0xFFULL;
+constexpr uint64_t row(int r) { return ROW_0 << (8 * r); }
+
+// bit r * 8 + c -> north (+r) is << 8 && east (+c) is << 1
+enum Direction {
+  NORTH, SOUTH, EAST, WEST, NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST
+};
+constexpr int offset(Direction d) {
+  constexpr int offsets[] = {8, -8, 1, -1, 9, 7, -7, -9};
+  return offsets[d];
+}
+// squares that can't be reached w/o wrapping around the board edge
+constexpr uint64_t wrap_mask(Direction d) {
+  constexpr uint64_t masks[] = {~0ULL, ~0ULL, ~FILE_A, ~FILE_H, ~FILE_A, ~FILE_H, ~FILE_A, ~FILE_H};
+  return masks[d];
+}
+
+template<int OFFSET, class V>
+inline V shift(V b) {
+  if constexpr (OFFSET >= 0)
+    return shl<OFFSET>(b);
+  else
+    return shr<-OFFSET>(b);
+}
+
+template<Direction D, class V>
+inline V step(V b) { return shift<offset(D)>(b) & V::all(wrap_mask(D)); }
+
+// Kogge-Stone occluded fill -> gen spread along D through the squares of pro
+template<Direction D, class V>
+inline V fill(V gen, V pro) {
+  pro = pro & V::all(wrap_mask(D));
+  gen = gen | (pro & shift<offset(D)>(gen));
+  pro = pro & shift<offset(D)>(pro);
+  gen = gen | (pro & shift<2 * offset(D)>(gen));
+  pro = pro & shift<2 * offset(D)>(pro);
+  gen = gen | (pro & shift<4 * offset(D)>(gen));
+  return gen;
+}
+
+// squares slid over from gen in direction D, up to && including the first blocker
+template<Direction D, class V>
+inline V ray(V gen, V empty) { return step<D>(fill<D>(gen, empty)); }
+
+template<class V>
+inline V orthogonal_attacks(V sliders, V empty) {
+  return ray<NORTH>(sliders, empty) | ray<SOUTH>(sliders, empty) |
+         ray<EAST>(sliders, empty) | ray<WEST>(sliders, empty);
+}
+template<class V>
+inline V diagonal_attacks(V sliders, V empty) {
+  return ray<NORTH_EAST>(sliders, empty) | ray<NORTH_WEST>(sliders, empty) |
+         ray<SOUTH_EAST>(sliders, empty) | ray<SOUTH_WEST>(sliders, empty);
+}
+
+template<class V>
+inline V king_attacks(V kings) {
+  V sideways = step<EAST>(kings) | step<WEST>(kings);
+  V row = kings | sideways;
+  return sideways | shl<8>(row) | shr<8>(row);
+}
+
+// the 8 knight jumps as (shift, mask of squares that can be landed on)
+template<int JUMP, class V>
+inline V knight_jump(V knights) {
+  constexpr int offsets[] = {17, 15, 10, 6, -6, -10, -15, -17};
+  constexpr uint64_t masks[] = {~FILE_A, ~FILE_H, ~(FILE_A | FILE_B), ~(FILE_G | FILE_H),
+                                ~(FILE_A | FILE_B), ~(FILE_G | FILE_H), ~FILE_A, ~FILE_H};
+  return shift<offsets[JUMP]>(knights) & V::all(masks[JUMP]);
+}
+template<class V>
+inline V knight_attacks(V knights) {
+  return knight_jump<0>(knights) | knight_jump<1>(knights) | knight_jump<2>(knights) | knight_jump<3>(knights) |
+         knight_jump<4>(knights) | knight_jump<5>(knights) | knight_jump<6>(knights) | knight_jump<7>(knights);
+}
+
+// (mask ? a: b) for all-ones/all-zeros masks
+template<class V>
+inline V select(V mask, V a, V b) { return (mask & a) | (~mask & b); }
+
+// pinned pieces are tracked per line they're pinned along
+enum Line {
+  VERTICAL, HORIZONTAL, DIAGONAL, ANTI_DIAGONAL
+};
+
+// Legality details that match game::Board/piece::Piece (not always standard chess):
+//   - en passant removes the captured pawn too -> it can capture a checking pawn && can uncover a slider
+//     (ie both pawns leave the king's row), so it is checked on the board after the capture instead of w/ pins
+//   - castling needs the king && rook unmoved, the square the king crosses empty && both it && the
+//     destination unattacked -> the rook's path (b-file) may be occupied && the destination may hold an enemy piece
+template<class V>
+class KingSafety {
+  public:
+    V checkers, check_block, pinned, pin_lines[4];
+
+    template<Direction D, Line L>
+    inline void scan(V king, V own, V empty, V sliders) {
+      V seen = ray<D>(king, empty);
+      V blocker = seen & own;
+      V behind = ray<D>(king, empty | blocker);
+
+      V check = seen & sliders;
+      checkers = checkers | check;
+      check_block = check_block | (nonzero(check) & seen);
+
+      V pin = nonzero(blocker) & nonzero(behind & sliders) & blocker;
+      pinned = pinned | pin;
+      pin_lines[L] = pin_lines[L] | pin;
+    }
+};
+
+// number of moves sliding in direction D that land on a target square
+template<Direction D, class V>
+inline V slide_count(V movers, V empty, V targets) {
+  V count = V::all(0);
+  for (int i = 0; i < 7; ++i) {
+    movers = step<D>(movers);
+    count = count + popcount(movers & targets);
+    movers = movers & empty;
+  }
+  return count;
+}
+
+// pawn moves onto the last row are 4 moves (one per promotion type)
+template<class V>
+inline V pawn_count(V targets) {
+  V last_row = V::all(row(7));
+  return popcount(targets & ~last_row) + shl<2>(popcount(targets & last_row));
+}
+
+// en passant in direction D (NORTH_EAST or NORTH_WEST) -> legal iff after the capture no enemy slider sees the
+// king && no knight/pawn other than the captured one still gives check
+template<Direction D, class V>
+inline V en_passant_count(V en_passant, V own_pawns, V king, V empty, V enemy_orthogonal, V enemy_diagonal,
+                          V leaper_checkers) {
+  constexpr Direction BACK = D == NORTH_EAST ? SOUTH_WEST: SOUTH_EAST;
+  V from = step<BACK>(en_passant) & own_pawns;
+  V to = step<D>(from);
+  V captured = step<SOUTH>(to);
+  V after = (empty | from | captured) & ~to;
+  V exposed = (orthogonal_attacks(king, after) & enemy_orthogonal) |
+              (diagonal_attacks(king, after) & enemy_diagonal) | (leaper_checkers & ~captured);
+  return nonzero(from) & ~nonzero(exposed) & V::all(1);
+}
+
+template<class V>
+inline void analyze_lanes(const bitboard::PositionBatch &batch, int first, bitboard::BatchResult *result) {
+  using bitboard::PositionBatch;
+
+  V own = V::load(batch.bitboards(PositionBatch::OWN) + first);
+  V enemy = V::load(batch.bitboards(PositionBatch::ENEMY) + first);
+  V pawns = V::load(batch.bitboards(PositionBatch::PAWNS) + first);
+  V knights = V::load(batch.bitboards(PositionBatch::KNIGHTS) + first);
+  V bishops = V::load(batch.bitboards(PositionBatch::BISHOPS) + first);
+  V rooks = V::load(batch.bitboards(PositionBatch::ROOKS) + first);
+  V queens = V::load(batch.bitboards(PositionBatch::QUEENS) + first);
+  V kings = V::load(batch.bitboards(PositionBatch::KINGS) + first);
+  V flags = V::load(batch.bitboards(PositionBatch::FLAGS) + first);
+
+  const V ALL = V::all(~0ULL), NONE = V::all(0);
+  V empty = ~(own | enemy);
+  V king = own & kings;
+
+  // enemy attacks -> "unsafe" looks through the king, so it can't step back along a checking ray
+  V enemy_orthogonal = enemy & (rooks | queens), enemy_diagonal = enemy & (bishops | queens);
+  V enemy_pawns = enemy & pawns, enemy_knights = enemy & knights;
+  V leaper_attacks = step<SOUTH_EAST>(enemy_pawns) | step<SOUTH_WEST>(enemy_pawns) |
+                     knight_attacks(enemy_knights) | king_attacks(enemy & kings);
+  V attacked = leaper_attacks | orthogonal_attacks(enemy_orthogonal, empty) |
+               diagonal_attacks(enemy_diagonal, empty);
+  V unsafe = leaper_attacks | orthogonal_attacks(enemy_orthogonal, empty | king) |
+             diagonal_attacks(enemy_diagonal, empty | king);
+
+  // checks && pins, scanning outwards from the king
+  KingSafety<V> safety{};
+  safety.checkers = (knight_attacks(king) & enemy_knights) |
+                    ((step<NORTH_EAST>(king) | step<NORTH_WEST>(king)) & enemy_pawns);
+  safety.check_block = safety.checkers;
+  safety.pinned = NONE;
+  for (V &line: safety.pin_lines)
+    line = NONE;
+  safety.template scan<NORTH, VERTICAL>(king, own, empty, enemy_orthogonal);
+  safety.template scan<SOUTH, VERTICAL>(king, own, empty, enemy_orthogonal);
+  safety.template scan<EAST, HORIZONTAL>(king, own, empty, enemy_orthogonal);
+  safety.template scan<WEST, HORIZONTAL>(king, own, empty, enemy_orthogonal);
+  safety.template scan<NORTH_EAST, DIAGONAL>(king, own, empty, enemy_diagonal);
+  safety.template scan<SOUTH_WEST, DIAGONAL>(king, own, empty, enemy_diagonal);
+  safety.template scan<NORTH_WEST, ANTI_DIAGONAL>(king, own, empty, enemy_diagonal);
+  safety.template scan<SOUTH_EAST, ANTI_DIAGONAL>(king, own, empty, enemy_diagonal);
+
+  V in_check = nonzero(safety.checkers);
+  V double_check = nonzero(safety.checkers & (safety.checkers - V::all(1)));
+
+  // non-king moves must block/capture a single checker && can't land on their own pieces
+  V targets = select(in_check, safety.check_block, ALL) & ~double_check & ~own;
+  V free = ~safety.pinned;
+  V vertical = free | safety.pin_lines[VERTICAL], horizontal = free | safety.pin_lines[HORIZONTAL];
+  V diagonal = free | safety.pin_lines[DIAGONAL], anti_diagonal = free | safety.pin_lines[ANTI_DIAGONAL];
+
+  V count = NONE;
+
+  // sliders
+  V orthogonal = own & (rooks | queens), diagonals = own & (bishops | queens);
+  count = count + slide_count<NORTH>(orthogonal & vertical, empty, targets);
+  count = count + slide_count<SOUTH>(orthogonal & vertical, empty, targets);
+  count = count + slide_count<EAST>(orthogonal & horizontal, empty, targets);
+  count = count + slide_count<WEST>(orthogonal & horizontal, empty, targets);
+  count = count + slide_count<NORTH_EAST>(diagonals & diagonal, empty, targets);
+  count = count + slide_count<SOUTH_WEST>(diagonals & diagonal, empty, targets);
+  count = count + slide_count<NORTH_WEST>(diagonals & anti_diagonal, empty, targets);
+  count = count + slide_count<SOUTH_EAST>(diagonals & anti_diagonal, empty, targets);
+
+  // knights -> a pinned knight can never move
+  V free_knights = own & knights & free;
+  count = count + popcount(knight_jump<0>(free_knights) & targets) + popcount(knight_jump<1>(free_knights) & targets);
+  count = count + popcount(knight_jump<2>(free_knights) & targets) + popcount(knight_jump<3>(free_knights) & targets);
+  count = count + popcount(knight_jump<4>(free_knights) & targets) + popcount(knight_jump<5>(free_knights) & targets);
+  count = count + popcount(knight_jump<6>(free_knights) & targets) + popcount(knight_jump<7>(free_knights) & targets);
+
+  // pawns
+  V own_pawns = own & pawns;
+  V single_push = step<NORTH>(own_pawns & vertical) & empty;
+  V double_push = step<NORTH>(single_push & V::all(row(2))) & empty;
+  count = count + pawn_count(single_push & targets) + popcount(double_push & targets);
+
+  V capturable = enemy & targets;
+  count = count + pawn_count(step<NORTH_EAST>(own_pawns & diagonal) & capturable);
+  count = count + pawn_count(step<NORTH_WEST>(own_pawns & anti_diagonal) & capturable);
+
+  // en passant -> rare, so only worked out if some lane has one
+  V en_passant = step<NORTH>(enemy_pawns & flags & V::all(row(4))) & empty;
+  uint64_t passed[V::LANES];
+  en_passant.store(passed);
+  bool has_en_passant = false;
+  for (uint64_t square: passed)
+    has_en_passant |= square != 0;
+  if (has_en_passant) {
+    V leaper_checkers = safety.checkers & (enemy_knights | enemy_pawns);
+    count = count + en_passant_count<NORTH_EAST>(en_passant, own_pawns, king, empty, enemy_orthogonal,
+                                                 enemy_diagonal, leaper_checkers);
+    count = count + en_passant_count<NORTH_WEST>(en_passant, own_pawns, king, empty, enemy_orthogonal,
+                                                 enemy_diagonal, leaper_checkers);
+  }
+
+  // king
+  count = count + popcount(king_attacks(king) & ~own & ~unsafe);
+
+  V unmoved_king = king & ~flags & ~in_check;
+  V unmoved_rooks = own & rooks & ~flags;
+  V king_row = fill<EAST>(unmoved_king, ALL) | fill<WEST>(unmoved_king, ALL);
+  V blocked = ~empty | unsafe;
+
+  V cross = step<EAST>(unmoved_king), destination = step<EAST>(cross);
+  V castle = nonzero(destination) & nonzero(king_row & unmoved_rooks & V::all(FILE_H)) &
+             ~nonzero((cross & blocked) | (destination & (own | unsafe)));
+  count = count + (castle & V::all(1));
+
+  cross = step<WEST>(unmoved_king), destination = step<WEST>(cross);
+  castle = nonzero(destination) & nonzero(king_row & unmoved_rooks & V::all(FILE_A)) &
+           ~nonzero((cross & blocked) | (destination & (own | unsafe)));
+  count = count + (castle & V::all(1));
+
+  // write results
+  uint64_t checks[V::LANES], counts[V::LANES];
+  attacked.store(result->attacked.data() + first);
+  in_check.store(checks);
+  count.store(counts);
+  for (int i = 0; i < V::LANES; ++i) {
+    result->in_check[first + i] = checks[i] != 0;
+    result->legal_moves[first + i] = (uint16_t) counts[i];
+  }
+}
+
+}
+
+#endif // CHESS_AI_CHESS_BITBOARD_KERNEL_H_
@@ -29,8 +29,12 @@
 #include <sstream>
 #include <vector>
 #include <utility>
+#include <algorithm>
+#include <cctype>
 
 #include "piece.h"
+#include "zobrist.h"
+#include "move_cache.h"
 #include "../util/thread_util.h"
 #include "../graphics/opengl.h"
 
@@ -44,6 +48,11 @@ game::Board::Board(int l, int w) {
   int i, total = _length * _width;
   for (i = 0; i < total; ++i)
     _pieces.push_back(nullptr);
+
+  _codes.assign(total, 0.0);
+  _hash = _pawn_hash = 0;
+  _piece_list_index.assign(total, -1);
+  _next_listener_id = 0;
 }
 
 game::Board::~Board() {
@@ -61,6 +70,11 @@ game::Board::~Board() {
     _move_stack.pop();
     delete move;
   }
+
+  for (auto &spare : _spare_moves)
+    delete spare;
+  for (auto &spare : _spare_squares)
+    delete spare;
 }
 
 int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) const {
@@ -75,11 +89,11 @@ int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) c
   piece::Piece *checkPiece;
 
   // Check axis attacks (queen/rook)
-  std::vector<std::vector<int>> axisCheck = {{1,  0},
-                                             {-1, 0},
-                                             {0,  1},
-                                             {0,  -1}};
-  for (std::vector<int> axis: axisCheck) {
+  static constexpr int axisCheck[4][2] = {{1,  0},
+                                          {-1, 0},
+                                          {0,  1},
+                                          {0,  -1}};
+  for (const int *axis: axisCheck) {
     x = r + axis[0];
     y = c + axis[1];
     while (isValidPosition(x, y)) {
@@ -99,11 +113,11 @@ int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) c
   }
 
   // Check diagonal attacks (queen/bishop)
-  std::vector<std::vector<int>> diagCheck = {{1,  1},
-                                             {1,  -1},
-                                             {-1, 1},
-                                             {-1, -1}};
-  for (std::vector<int> diag: diagCheck) {
+  static constexpr int diagCheck[4][2] = {{1,  1},
+                                          {1,  -1},
+                                          {-1, 1},
+                                          {-1, -1}};
+  for (const int *diag: diagCheck) {
     x = r + diag[0];
     y = c + diag[1];
     while (isValidPosition(x, y)) {
@@ -133,7 +147,7 @@ int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) c
         dangerCounter++;
     }
 
-  std::vector<int> pm1 = {1, -1};
+  static constexpr int pm1[2] = {1, -1};
 
   // Check pawn attacks
   x = r + (enemyColor.isWhite() ? -1: 1); // if enemy is white, pawn attacks from below; otherwise from above
@@ -149,9 +163,9 @@ int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) c
   }
 
   // Check knight attacks
-  std::vector<std::vector<int>> knightMoves = {{1, 2},
-                                               {2, 1}};
-  for (std::vector<int> move: knightMoves)
+  static constexpr int knightMoves[2][2] = {{1, 2},
+                                            {2, 1}};
+  for (const int *move: knightMoves)
     for (int mr: pm1)
       for (int mc: pm1) {
         x = r + mr * move[0];
@@ -169,23 +183,16 @@ int game::Board::getPositionThreats(int r, int c, piece::PieceColor kingColor) c
 }
 
 std::pair<int, int> game::Board::getKingPosition(piece::PieceColor color) const {
-  piece::Piece *checkPiece;
-  int xKing = -1, yKing = -1, r, c;
-
-  for (r = 0; r < _length; ++r) {
-    for (c = 0; c < _width; ++c) {
-      checkPiece = getPiece(r, c);
-      if (checkPiece->type().isKing() && checkPiece->color() == color) {
-        xKing = r;
-        yKing = c;
-        break;
-      }
-    }
-    if (xKing != -1)
-      break;
+  if (!color.isColored()) {
+    DEBUG_ASSERT
+    return {-1, -1};
   }
 
-  return {xKing, yKing};
+  for (int square : _piece_lists[color])
+    if (_pieces[square]->type().isKing())
+      return {square / _width, square % _width};
+
+  return {-1, -1};
 }
 
 bool game::Board::canPieceMove(int r, int c, int toR, int toC) {
@@ -205,21 +212,31 @@ bool game::Board::canPieceMove(int r, int c, int toR, int toC) {
 
   // save replaced piece (b/c to is overwritten by from)
   piece::Piece *copy = _pieces[to];
-  auto *newPiece = new piece::Piece();
+  piece::Piece *newPiece = takeEmptySquare();
+
+  // en passant -> the captured pawn is beside the target square && leaves the row too (can uncover a rook/queen)
+  int passed = -1;
+  piece::Piece *passedPawn = nullptr;
+  if (_pieces[from]->type().isPawn() && c != toC && _pieces[to]->type().isEmpty()) {
+    passed = locMap(r, toC);
+    passedPawn = _pieces[passed];
+    _pieces[passed] = newPiece;
+  }
 
   // simulate move
   _pieces[to] = _pieces[from];
   _pieces[from] = newPiece;
 
-  // score threats
-  bool isSafe = isKingSafe(pieceColor);
+  // score threats -> piece lists aren't updated for the simulated move, so a moving king is checked directly
+  bool isSafe = _pieces[to]->type().isKing() ? isPositionSafe(toR, toC, pieceColor): isKingSafe(pieceColor);
 
   // undo move
   _pieces[from] = _pieces[to];
   _pieces[to] = copy;
+  if (passed >= 0)
+    _pieces[passed] = passedPawn;
 
-  // free memory
-  delete newPiece;
+  releaseEmptySquare(newPiece);
 
   // return result
   return isSafe; // move allowed iff king is safe post-move
@@ -236,10 +253,18 @@ void game::Board::getMovesFromSquare(int r, int c, std::vector<game::Move> *move
         if (r == r2 && c == c2)
           continue;
 
-        std::vector<Move> poss_moves = Move::getMoves(r, c, r2, c2, this);
-        for (const Move &move: poss_moves)
+        if (getPiece(r, c)->type().isPawn() && (r2 == 0 || r2 == 7)) {
+          for (piece::PieceType type : {piece::PieceType::QUEEN, piece::PieceType::ROOK, piece::PieceType::KNIGHT,
+                                        piece::PieceType::BISHOP}) {
+            Move move(r, c, r2, c2, type);
+            if (move.verify(this))
+              moves->push_back(move);
+          }
+        } else {
+          Move move(r, c, r2, c2, piece::PieceType::NONE);
           if (move.verify(this))
             moves->push_back(move);
+        }
       }
   } else DEBUG_ASSERT
 }
@@ -262,6 +287,25 @@ void game::Board::getPossibleMoves(std::vector<game::Move> *white, std::vector<g
       }
 }
 
+void game::Board::getCachedMoves(piece::PieceColor color, std::vector<game::Move> *moves) {
+  if (moves == nullptr || !color.isColored()) {
+    DEBUG_ASSERT
+    return;
+  }
+
+  MoveCache *cache = MoveCache::shared();
+  uint64_t key = hash() ^ zobrist::color_key(color);
+  if (cache->probe(key, moves))
+    return;
+
+  std::size_t first = moves->size();
+  if (color.isWhite())
+    getPossibleMoves(moves, nullptr);
+  else
+    getPossibleMoves(nullptr, moves);
+  cache->store(key, *moves, first);
+}
+
 bool game::Board::doMove(Move *move, Game *game) {
   if (move == nullptr) {
     DEBUG_ASSERT
@@ -271,15 +315,24 @@ bool game::Board::doMove(Move *move, Game *game) {
   _move_count++;
 
   bool isCaptureMove = move->doMove(this);
+  updateChangedSquares(move, false);
 
-  if (game != nullptr) {
+  if (game != nullptr)
     game->_current_player_color = _move_count % 2 == 0 ? piece::PieceColor::WHITE: piece::PieceColor::BLACK;
-    game->updateGraphicsBoard(this);
-  }
 
   return isCaptureMove;
 }
 
+bool game::Board::doMove(const Move &move, Game *game) {
+  if (_spare_moves.empty())
+    return doMove(new Move(move), game);
+
+  Move *copy = _spare_moves.back();
+  _spare_moves.pop_back();
+  *copy = move;
+  return doMove(copy, game);
+}
+
 void game::Board::undoMove(Game *game, const int depth) {
   if (depth <= 0 || _move_stack.size() < depth) {
     DEBUG_ASSERT
@@ -290,12 +343,12 @@ void game::Board::undoMove(Game *game, const int depth) {
   Move *move = _move_stack.top();
   move->undoMove(this);
   _move_stack.pop();
-  delete move;
+  updateChangedSquares(move, true);
+  _spare_moves.push_back(move); // undone -> holds no pieces anymore
 
   if (depth == 1) {
     if (game != nullptr) {
       game->_current_player_color = _move_count % 2 == 0 ? piece::PieceColor::WHITE: piece::PieceColor::BLACK;
-      game->updateGraphicsBoard(this);
       game->resetSelection();
       game->updateGameState();
     }
@@ -307,6 +360,144 @@ game::Move *game::Board::getLastMove() const {
   return _move_stack.empty() ? nullptr: new Move(*_move_stack.top());
 }
 
+std::vector<game::Move> game::Board::moveHistory() const {
+  std::stack<Move *, std::vector<Move *>> stack = _move_stack;
+  std::vector<Move> moves;
+  moves.reserve(stack.size());
+  while (!stack.empty()) {
+    moves.push_back(*stack.top());
+    stack.pop();
+  }
+  std::reverse(moves.begin(), moves.end());
+  return moves;
+}
+
+int game::Board::addListener(const BoardListener &listener) {
+  std::lock_guard<std::mutex> lock(_listener_mutex);
+  _listeners[_next_listener_id] = listener;
+  _listener_count = (int) _listeners.size();
+  return _next_listener_id++;
+}
+
+void game::Board::removeListener(int listener_id) {
+  std::lock_guard<std::mutex> lock(_listener_mutex);
+  if (_listeners.erase(listener_id) == 0) DEBUG_ASSERT
+  _listener_count = (int) _listeners.size();
+}
+
+void game::Board::applyDelta(const BoardDelta &delta) {
+  for (int i = 0; i < delta.size; ++i) {
+    const BoardDelta::Change &change = delta.changes[i];
+    if (change.old_code != _codes[change.square]) DEBUG_ASSERT // delta is from a different position
+
+    delete _pieces[change.square];
+    _pieces[change.square] = getPieceOfCode(change.new_code);
+
+    _hash ^= zobrist::key(_codes[change.square], change.square) ^ zobrist::key(change.new_code, change.square);
+    _pawn_hash ^= zobrist::pawn_key(_codes[change.square], change.square) ^
+                  zobrist::pawn_key(change.new_code, change.square);
+    updatePieceLists(change.square, _codes[change.square], change.new_code);
+    _codes[change.square] = change.new_code;
+  }
+  _move_count.store(delta.move_count);
+}
+
+void game::Board::refreshCodes() {
+  int i, total = (int) _pieces.size();
+  _codes.assign(total, 0.0);
+  _hash = _pawn_hash = 0;
+
+  _piece_lists[piece::PieceColor::BLACK].clear();
+  _piece_lists[piece::PieceColor::WHITE].clear();
+  _piece_list_index.assign(total, -1);
+
+  for (i = 0; i < total; ++i) {
+    _codes[i] = _pieces[i]->code();
+    _hash ^= zobrist::key(_codes[i], i);
+    _pawn_hash ^= zobrist::pawn_key(_codes[i], i);
+    updatePieceLists(i, 0.0, _codes[i]);
+  }
+}
+
+void game::Board::updatePieceLists(int square, double old_code, double new_code) {
+  // code sign is the piece color: + for white, - for black, 0 for empty
+  int old_color = old_code > 0 ? piece::PieceColor::WHITE: old_code < 0 ? piece::PieceColor::BLACK: -1;
+  int new_color = new_code > 0 ? piece::PieceColor::WHITE: new_code < 0 ? piece::PieceColor::BLACK: -1;
+  if (old_color == new_color)
+    return;
+
+  if (old_color != -1) { // swap w/ last square in list, then pop
+    std::vector<int> &list = _piece_lists[old_color];
+    int index = _piece_list_index[square];
+    list[index] = list.back();
+    _piece_list_index[list[index]] = index;
+    list.pop_back();
+    _piece_list_index[square] = -1;
+  }
+
+  if (new_color != -1) {
+    std::vector<int> &list = _piece_lists[new_color];
+    _piece_list_index[square] = (int) list.size();
+    list.push_back(square);
+  }
+}
+
+void game::Board::updateChangedSquares(const Move *move, bool is_undo) {
+  int squares[BoardDelta::MAX_CHANGES];
+  int count = move->changedSquares(this, squares);
+
+  BoardDelta delta{};
+  int square;
+  double code;
+  for (int i = 0; i < count; ++i) {
+    square = squares[i];
+    code = _pieces[square]->code();
+    if (code == _codes[square])
+      continue;
+
+    _hash ^= zobrist::key(_codes[square], square) ^ zobrist::key(code, square);
+    _pawn_hash ^= zobrist::pawn_key(_codes[square], square) ^ zobrist::pawn_key(code, square);
+    delta.changes[delta.size++] = {square, _codes[square], code};
+    updatePieceLists(square, _codes[square], code);
+    _codes[square] = code;
+  }
+
+  if (_listener_count == 0)
+    return;
+
+  delta.is_undo = is_undo;
+  delta.move_count = _move_count;
+  delta.last_move_start = delta.last_move_end = -1;
+  if (!_move_stack.empty()) {
+    Move *last = _move_stack.top();
+    delta.last_move_start = locMap(last->startingRow(), last->startingColumn());
+    delta.last_move_end = locMap(last->endingRow(), last->endingColumn());
+  }
+
+  // listeners must not add/remove listeners from inside the callback
+  std::lock_guard<std::mutex> lock(_listener_mutex);
+  for (auto &it : _listeners)
+    it.second(this, delta);
+}
+
+piece::Piece *game::Board::takeEmptySquare() {
+  if (_spare_squares.empty())
+    return new piece::Piece();
+
+  piece::Piece *square = _spare_squares.back();
+  _spare_squares.pop_back();
+  return square;
+}
+
+void game::Board::releaseEmptySquare(piece::Piece *square) {
+  if (square == nullptr || !square->type().isEmpty()) {
+    DEBUG_ASSERT
+    delete square;
+    return;
+  }
+  _spare_squares.push_back(square);
+}
+
 game::Board *game::Board::clone() const {
   auto *newBoard = new Board(_length, _width);
 
@@ -317,25 +508,19 @@ game::Board *game::Board::clone() const {
   newBoard->_pawn_upgrade_type = piece::PieceType::NONE;
   newBoard->_move_count.store(_move_count.operator int());
 
+  newBoard->_codes = _codes;
+  newBoard->_hash = _hash;
+  newBoard->_pawn_hash = _pawn_hash;
+  newBoard->_piece_lists[piece::PieceColor::BLACK] = _piece_lists[piece::PieceColor::BLACK];
+  newBoard->_piece_lists[piece::PieceColor::WHITE] = _piece_lists[piece::PieceColor::WHITE];
+  newBoard->_piece_list_index = _piece_list_index;
+
   if (!_move_stack.empty())
     newBoard->_move_stack.push(new Move(*_move_stack.top()));
 
   return newBoard;
 }
 
-double game::Board::score(const std::function<double(piece::Piece *)> &piece_scorer) const {
-  double score = 0;
-  for (const auto &piece: _pieces)
-    score += piece_scorer(piece);
-  return score;
-}
-double game::Board::score(const std::function<double(piece::Piece *, int, int)> &piece_scorer) const {
-  double score = 0;
-  for (int r = 0; r < _length; ++r)
-    for (int c = 0; c < _width; ++c)
-      score += piece_scorer(getPiece(r, c), r, c);
-  return score;
-}
 
 
 namespace game {
@@ -365,6 +550,7 @@ std::istream &operator>>(std::istream &input, Board *&b) {
     else DEBUG_ASSERT // -> Malformed input file!!
     getline(input, spacer); // skip to end of line
   }
+  b->refreshCodes();
 
   return input;
 }
@@ -400,24 +586,168 @@ void game::Board::loadFromFile(const std::string &file_path, const std::function
   } else DEBUG_ASSERT
 }
 
-// Move Class
-std::vector<game::Move> game::Move::getMoves(int r1, int c1, int r2, int c2, game::Board *b) {
-  std::vector<game::Move> moves;
-  piece::Piece *piece = b->getPiece(r1, c1);
-
-  if (piece != nullptr) {
-    if (piece->type().isPawn() && (r2 == 0 || r2 == 7)) {
-      moves.emplace_back(r1, c1, r2, c2, piece::PieceType::QUEEN);
-      moves.emplace_back(r1, c1, r2, c2, piece::PieceType::ROOK);
-      moves.emplace_back(r1, c1, r2, c2, piece::PieceType::KNIGHT);
-      moves.emplace_back(r1, c1, r2, c2, piece::PieceType::BISHOP);
-    } else
-      moves.emplace_back(r1, c1, r2, c2, piece::PieceType::NONE);
-  } else DEBUG_ASSERT
+bool game::Board::loadFromFEN(const std::string &fen, piece::PieceColor *to_move) {
+  std::istringstream input(fen);
+  std::string placement, side, castling = "-", en_passant = "-";
+  int half_moves = 0, full_moves = 1;
+  input >> placement >> side >> castling >> en_passant >> half_moves >> full_moves;
+  if (side != "w" && side != "b")
+    return false;
 
-  return moves;
+  // letters in PieceType order (KING, QUEEN, ROOK, KNIGHT, BISHOP, PAWN) -> upper case for white
+  const std::string LETTERS = "kqrnbp";
+  piece::PieceType types[64];
+  piece::PieceColor colors[64];
+  std::fill(types, types + 64, piece::PieceType::NONE);
+  std::fill(colors, colors + 64, piece::PieceColor::NONE);
+
+  // fen starts w/ rank 8 -> row 7
+  int r = 7, c = 0;
+  for (char ch : placement) {
+    if (ch == '/') {
+      if (c != 8 || r == 0)
+        return false;
+      --r;
+      c = 0;
+    } else if ('1' <= ch && ch <= '8') {
+      c += ch - '0';
+    } else {
+      std::size_t type = LETTERS.find((char) std::tolower(ch));
+      if (type == std::string::npos || c >= 8)
+        return false;
+      types[r * 8 + c] = (piece::PieceType::Type) type;
+      colors[r * 8 + c] = std::isupper(ch) ? piece::PieceColor::WHITE: piece::PieceColor::BLACK;
+      ++c;
+    }
+    if (c > 8)
+      return false;
+  }
+  if (r != 0 || c != 8)
+    return false;
+
+  // en passant square -> the pawn that just moved 2x is one row past it
+  int en_passant_square = -1;
+  if (en_passant != "-") {
+    if (en_passant.size() != 2 || en_passant[0] < 'a' || en_passant[0] > 'h' ||
+        (en_passant[1] != '3' && en_passant[1] != '6'))
+      return false;
+    en_passant_square = (en_passant[1] == '3' ? 3: 4) * 8 + (en_passant[0] - 'a');
+  }
+
+  // exactly one king per side -> every search assumes it can find (&& never capture) them
+  int kings[2] = {0, 0};
+  for (int i = 0; i < 64; ++i)
+    if (types[i].isKing())
+      ++kings[colors[i]];
+  if (kings[piece::PieceColor::BLACK] != 1 || kings[piece::PieceColor::WHITE] != 1)
+    return false;
+
+  std::vector<piece::Piece *> pieces(64, nullptr);
+  for (int i = 0; i < 64; ++i) {
+    bool flag = false;
+    bool white = colors[i].isWhite();
+    int home_row = white ? 0: 7;
+    if (types[i].isKing()) // moved -> no castling rights left
+      flag = i != home_row * 8 + 4 || (castling.find(white ? 'K': 'k') == std::string::npos &&
+                                       castling.find(white ? 'Q': 'q') == std::string::npos);
+    else if (types[i].isRook())
+      flag = !((i == home_row * 8 + 7 && castling.find(white ? 'K': 'k') != std::string::npos) ||
+               (i == home_row * 8 && castling.find(white ? 'Q': 'q') != std::string::npos));
+    else if (types[i].isPawn())
+      flag = i == en_passant_square;
+    pieces[i] = getPieceOfTypeAndColor(types[i], colors[i], flag);
+  }
+
+  // the side that just moved can't be left in check -> put the old board back
+  int old_length = _length, old_width = _width;
+  _length = _width = 8;
+  _pieces.swap(pieces);
+  refreshCodes();
+  piece::PieceColor side_to_move = side == "w" ? piece::PieceColor::WHITE: piece::PieceColor::BLACK;
+  if (!isKingSafe(!side_to_move)) {
+    _length = old_length;
+    _width = old_width;
+    _pieces.swap(pieces);
+    if (std::find(_pieces.begin(), _pieces.end(), nullptr) == _pieces.end()) {
+      refreshCodes();
+    } else { // new board that was never filled (see Board(...)) -> nothing to refresh, only the lists to empty
+      _codes.assign(_pieces.size(), 0.0);
+      _hash = _pawn_hash = 0;
+      _piece_lists[piece::PieceColor::BLACK].clear();
+      _piece_lists[piece::PieceColor::WHITE].clear();
+      _piece_list_index.assign(_pieces.size(), -1);
+    }
+    for (auto &p : pieces)
+      delete p;
+    return false;
+  }
+
+  // memory management -> clear old board completely (see operator>>)
+  while (!_move_stack.empty()) {
+    delete _move_stack.top();
+    _move_stack.pop();
+  }
+  _pawn_upgrade_type = piece::PieceType::NONE;
+  for (auto &p : pieces)
+    delete p;
+
+  *to_move = side_to_move;
+  _move_count.store(2 * std::max(full_moves - 1, 0) + (side == "b"));
+  return true;
 }
 
+std::string game::Board::toFEN(piece::PieceColor to_move) const {
+  if (_length != 8 || _width != 8) {
+    DEBUG_ASSERT
+    return "";
+  }
+
+  const std::string LETTERS = "kqrnbp";
+  std::ostringstream output;
+  std::string castling, en_passant = "-";
+  for (int r = 7; r >= 0; --r) {
+    int empty = 0;
+    for (int c = 0; c < 8; ++c) {
+      piece::Piece *piece = _pieces[r * 8 + c];
+      if (piece->type().isEmpty()) {
+        ++empty;
+        continue;
+      }
+      if (empty > 0)
+        output << empty;
+      empty = 0;
+
+      char letter = LETTERS[piece->type()];
+      output << (piece->color().isWhite() ? (char) std::toupper(letter): letter);
+
+      // en passant -> only against the side to move
+      if (piece->type().isPawn() && piece->color() != to_move && static_cast<piece::Pawn *>(piece)->moved2x())
+        en_passant = std::string(1, (char) ('a' + c)) + (piece->color().isWhite() ? "3": "6");
+    }
+    if (empty > 0)
+      output << empty;
+    if (r > 0)
+      output << "/";
+  }
+
+  for (piece::PieceColor color : {piece::PieceColor::WHITE, piece::PieceColor::BLACK}) {
+    int home_row = color.isWhite() ? 0: 7;
+    piece::Piece *king = _pieces[home_row * 8 + 4];
+    if (!king->type().isKing() || king->color() != color || static_cast<piece::King *>(king)->moved())
+      continue;
+    for (int c : {7, 0}) {
+      piece::Piece *rook = _pieces[home_row * 8 + c];
+      if (rook->type().isRook() && rook->color() == color && !static_cast<piece::Rook *>(rook)->moved())
+        castling += color.isWhite() ? (c == 7 ? 'K': 'Q'): (c == 7 ? 'k': 'q');
+    }
+  }
+
+  output << " " << (to_move.isWhite() ? "w": "b") << " " << (castling.empty() ? "-": castling) << " " << en_passant
+         << " 0 " << move_count() / 2 + 1;
+  return output.str();
+}
+
+// Move Class
 game::Move::Move(int r1, int c1, int r2, int c2, piece::PieceType promotionType) {
   _start_row = r1;
   _start_col = c1;
@@ -437,15 +767,7 @@ game::Move::Move(const Move &m) {
 }
 
 game::Move::~Move() {
-  piece::Piece *piece;
-  for (auto &_other_replaced_piece : _other_replaced_pieces) {
-    piece = _other_replaced_pieces[_other_replaced_piece.first];
-    _other_replaced_pieces[_other_replaced_piece.first] = nullptr;
-    delete piece;
-  }
-  _other_replaced_pieces.clear();
-
-  _piece_setting_changes.clear();
+  clearState();
 }
 
 game::Move &game::Move::operator=(const Move &m) {
@@ -457,15 +779,33 @@ game::Move &game::Move::operator=(const Move &m) {
 
   _pawn_promotion_type = m._pawn_promotion_type;
 
-  for (auto &it : _other_replaced_pieces)
-    delete it.second;
-  _other_replaced_pieces.clear();
-
-  _piece_setting_changes.clear();
+  clearState();
 
   return *this;
 }
 
+void game::Move::clearState() {
+  delete _captured;
+  delete _promoted_pawn;
+  delete _passed_pawn;
+  _captured = _promoted_pawn = _passed_pawn = nullptr;
+  _castled = _en_passant = false;
+
+  _setting_change_count = 0;
+}
+
+uint16_t game::Move::pack() const {
+  auto from = (unsigned) (_start_row * 8 + _start_col), to = (unsigned) (_end_row * 8 + _end_col);
+  auto promotion = (unsigned) (piece::PieceType::Type) _pawn_promotion_type;
+  return (uint16_t) (from | (to << 6U) | (promotion << 12U));
+}
+
+game::Move game::Move::unpack(uint16_t packed) {
+  unsigned from = packed & 63U, to = (packed >> 6U) & 63U;
+  auto promotion = (piece::PieceType::Type) ((packed >> 12U) & 7U);
+  return Move((int) from / 8, (int) from % 8, (int) to / 8, (int) to % 8, promotion);
+}
+
 bool game::Move::verify(Board *board) const {
   // Implicit calls to:
   piece::Piece *p1 = board->getPiece(_start_row, _start_col);
@@ -502,20 +842,21 @@ bool game::Move::isAttack(Board *board) const {
   return _start_col != _end_col; // is pawn attack iff pawn moved sideways
 }
 
-void game::Move::addReplacedPiece(int r, int c, piece::Piece *p) {
-  if (p != nullptr)
-    _other_replaced_pieces[std::pair<int, int>(r, c)] = p;
-}
-
 void game::Move::addSettingChange(int r, int c, bool oldSetting) {
-  std::pair<int, int> coords = {r, c};
-  if (!_piece_setting_changes.count(coords))
-    _piece_setting_changes[coords] = false;
-  _piece_setting_changes[coords] |= oldSetting;
+  for (int i = 0; i < _setting_change_count; ++i)
+    if (_setting_changes[i].row == r && _setting_changes[i].col == c) {
+      _setting_changes[i].setting |= oldSetting;
+      return;
+    }
+
+  if (_setting_change_count < BoardDelta::MAX_CHANGES)
+    _setting_changes[_setting_change_count++] = {r, c, oldSetting};
+  else DEBUG_ASSERT
 }
 
 bool game::Move::doMove(Board *board) {
   std::vector<piece::Piece *> &pieces = getBoard(board);
+  clearState();
 
   piece::Piece *p;
   int r, c;
@@ -532,11 +873,16 @@ bool game::Move::doMove(Board *board) {
 
   int from = locMap(board, r1, c1), to = locMap(board, r2, c2);
 
+  // quiet -> the empty square just swaps places w/ the piece, capture -> the move holds the piece until undone
   piece::Piece *removedPiece = pieces[to];
   pieces[to] = pieces[from];
-  pieces[from] = new piece::Piece();
+  if (removedPiece->type().isEmpty())
+    pieces[from] = removedPiece;
+  else {
+    pieces[from] = takeEmptySquare(board);
+    _captured = removedPiece;
+  }
 
-  addReplacedPiece(r2, c2, removedPiece);
   switch (removedPiece->type()) {
     case piece::PieceType::ROOK:
       addSettingChange(r2, c2, ((piece::Rook *) removedPiece)->moved());
@@ -591,15 +937,8 @@ bool game::Move::doMove(Board *board) {
         int rookCol = (c2 > c1) * 7; // if c2 > c1, then king moved right, so rookCol = 7; else, rookCol = 0
         int newC = (c1 + c2) / 2;
 
-        int oldPos = locMap(board, r1, rookCol);
-        int newPos = locMap(board, r2, newC);
-
-        // clone rook b/c it gets deleted in undoMove() while restoring pieces -> segfault
-        addReplacedPiece(r1, rookCol, pieces[oldPos]->clone());
-        addReplacedPiece(r2, newC, pieces[newPos]);
-
-        pieces[newPos] = pieces[oldPos];
-        pieces[oldPos] = new piece::Piece();
+        std::swap(pieces[locMap(board, r1, rookCol)], pieces[locMap(board, r2, newC)]);
+        _castled = true;
       }
       break;
 
@@ -630,15 +969,14 @@ bool game::Move::doMove(Board *board) {
           FATAL_ASSERT
         }
 
-        addReplacedPiece(r1, c1, piece);
-        pieces[locMap(board, r2, c2)] = newPiece;
+        _promoted_pawn = piece;
+        pieces[to] = newPiece;
       }
       if (abs(c1 - c2) == 1 && removedPiece->type().isEmpty()) {
         int captured = locMap(board, r1, c2);
-        removedPiece = pieces[captured];
-        pieces[captured] = new piece::Piece();
-
-        addReplacedPiece(r1, c2, removedPiece);
+        removedPiece = _passed_pawn = pieces[captured];
+        pieces[captured] = takeEmptySquare(board);
+        _en_passant = true;
       }
       break;
 
@@ -649,6 +987,33 @@ bool game::Move::doMove(Board *board) {
   return !removedPiece->type().isEmpty();
 }
 
+int game::Move::changedSquares(Board *board, int squares[BoardDelta::MAX_CHANGES]) const {
+  int count = 0;
+  auto add_square = [&](int r, int c) -> void {
+    int square = locMap(board, r, c);
+    for (int i = 0; i < count; ++i)
+      if (squares[i] == square)
+        return;
+
+    if (count < BoardDelta::MAX_CHANGES)
+      squares[count++] = square;
+    else DEBUG_ASSERT
+  };
+
+  add_square(_start_row, _start_col);
+  add_square(_end_row, _end_col);
+  if (_castled) {
+    add_square(_start_row, (_end_col > _start_col) * 7);
+    add_square(_end_row, (_start_col + _end_col) / 2);
+  }
+  if (_en_passant)
+    add_square(_start_row, _end_col);
+  for (int i = 0; i < _setting_change_count; ++i)
+    add_square(_setting_changes[i].row, _setting_changes[i].col);
+
+  return count;
+}
+
 void game::Move::updateSetting(Board *board, int r, int c, bool setting) {
   piece::Piece *piece = getBoard(board)[locMap(board, r, c)];
 
@@ -670,26 +1035,42 @@ void game::Move::updateSetting(Board *board, int r, int c, bool setting) {
   }
 }
 
-void game::Move::undoMove(Board *board) const {
+void game::Move::undoMove(Board *board) {
   std::vector<piece::Piece *> &pieces = getBoard(board);
   int r1 = _start_row, c1 = _start_col, r2 = _end_row, c2 = _end_col;
+  int from = locMap(board, r1, c1), to = locMap(board, r2, c2);
 
-  int i1 = locMap(board, r1, c1), i2 = locMap(board, r2, c2);
-  delete pieces[i1]; // Delete old replacement piece!!!
-  pieces[i1] = pieces[i2]; // Move back main piece
-  pieces[i2] = nullptr; // Get rid of copy of moved piece so we don't segfault when putting back pieces (below)
+  // reverse of doMove -> every piece goes back to its square, nothing is cloned
+  // (the flags && setting changes are kept for changedSquares)
+  if (_en_passant) {
+    int captured = locMap(board, r1, c2);
+    releaseEmptySquare(board, pieces[captured]);
+    pieces[captured] = _passed_pawn;
+    _passed_pawn = nullptr;
+  }
+
+  if (_promoted_pawn != nullptr) {
+    delete pieces[to];
+    pieces[to] = _promoted_pawn;
+    _promoted_pawn = nullptr;
+  }
 
-  // Put back all other pieces
-  int index;
-  for (auto &it : _other_replaced_pieces) {
-    index = locMap(board, it.first.first, it.first.second);
-    delete pieces[index]; // free memory to avoid memory leaks
-    pieces[index] = it.second->clone();
+  if (_castled) {
+    int rookCol = (c2 > c1) * 7;
+    std::swap(pieces[locMap(board, r1, rookCol)], pieces[locMap(board, r2, (c1 + c2) / 2)]);
   }
 
+  if (_captured != nullptr) {
+    releaseEmptySquare(board, pieces[from]);
+    pieces[from] = pieces[to];
+    pieces[to] = _captured;
+    _captured = nullptr;
+  } else
+    std::swap(pieces[from], pieces[to]);
+
   // Fix move states
-  for (auto &it : _piece_setting_changes)
-    updateSetting(board, it.first.first, it.first.second, it.second);
+  for (int i = 0; i < _setting_change_count; ++i)
+    updateSetting(board, _setting_changes[i].row, _setting_changes[i].col, _setting_changes[i].setting);
 }
 
 std::string game::Move::toString() const {
@@ -699,6 +1080,14 @@ std::string game::Move::toString() const {
   return ss.str();
 }
 
+std::string game::Move::toLongAlgebraic() const {
+  std::string text = {(char) ('a' + _start_col), (char) ('1' + _start_row), (char) ('a' + _end_col),
+                      (char) ('1' + _end_row)};
+  if (!_pawn_promotion_type.isEmpty())
+    text += "kqrnbp"[_pawn_promotion_type];
+  return text;
+}
+
 // Game Class
 game::Game::Game(int length, int width) : Game(new Board(length, width)) {}
 
@@ -722,6 +1111,7 @@ game::Game::Game(Board *b) {
   _result = game::GameResult::NONE;
 
   _moves_since_last_capture = 0;
+  _legal_moves_move_count = -1;
 }
 
 game::Game::~Game() {
@@ -756,11 +1146,6 @@ void game::Game::setGraphics(graphics::OpenGL *graphics) {
   _graphics = graphics;
 }
 
-void game::Game::updateGraphicsBoard(Board *board) {
-  if (_graphics != nullptr)
-    _graphics->updateGraphics(board);
-}
-
 void game::Game::startGame() {
   if (_white_player == nullptr) {
     DEBUG_ASSERT
@@ -844,13 +1229,30 @@ void game::Game::selectSquare(int x, int y) {
   }
 }
 
+bool game::Game::isLegalMove(const Move &move) const {
+  if (!_board->isValidPosition(move.startingRow(), move.startingColumn()) ||
+      !_board->isValidPosition(move.endingRow(), move.endingColumn()))
+    return false;
+
+  // legal move bitmask is stale (board changed w/o this game) -> fall back to full verification
+  if (_legal_moves_move_count != _board->move_count())
+    return move.verify(_board);
+
+  return _legal_moves[move.pack() & 4095U]; // only start/end squares -> promotion type is picked in doMove
+}
+
 bool game::Game::tryMove(const Move &move) {
   // check if move is valid
-  if (!move.verify(_board))
+  if (!isLegalMove(move))
     return false;
 
+  applyMove(move);
+  return true;
+}
+
+void game::Game::applyMove(const Move &move) {
   // do move
-  bool isCapture = _board->doMove(new Move(move), this);
+  bool isCapture = _board->doMove(move, this);
 
   // check for 50 move no-capture stalemate
   if (!isCapture)
@@ -866,7 +1268,6 @@ bool game::Game::tryMove(const Move &move) {
 
   // move complete
   _is_move_complete = true;
-  return true;
 }
 
 void game::Game::updateGameState() {
@@ -889,11 +1290,44 @@ void game::Game::updateGameState() {
   }
 }
 
+bool game::Game::loadFromFEN(const std::string &fen) {
+  piece::PieceColor to_move;
+  if (!_board->loadFromFEN(fen, &to_move))
+    return false;
+
+  // a finished game is over no more -> but not restarted either (see updateGameState())
+  _current_player_color = to_move;
+  _over = false;
+  _result = game::GameResult::NONE;
+  _is_move_complete = false;
+  _moves_since_last_capture = 0;
+  resetSelection();
+  updateGameState();
+  return true;
+}
+
+bool game::Game::findMove(const std::string &text, Move *move) const {
+  for (const Move &legal_move : possibleMoves(_current_player_color))
+    if (legal_move.toLongAlgebraic() == text) {
+      *move = legal_move;
+      return true;
+    }
+  return false;
+}
+
 void game::Game::generatePossibleMoveVectors() {
   _white_moves.clear();
   _black_moves.clear();
 
-  _board->getPossibleMoves(&_white_moves, &_black_moves);
+  _board->getCachedMoves(piece::PieceColor::WHITE, &_white_moves);
+  _board->getCachedMoves(piece::PieceColor::BLACK, &_black_moves);
+
+  _legal_moves.reset();
+  for (const Move &move: _white_moves)
+    _legal_moves.set(move.pack() & 4095U);
+  for (const Move &move: _black_moves)
+    _legal_moves.set(move.pack() & 4095U);
+  _legal_moves_move_count = _board->move_count();
 }
 
 std::vector<game::Move> game::Game::possibleMoves() const { return possibleMoves(piece::PieceColor::NONE); }
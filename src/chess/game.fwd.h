@@ -37,6 +37,7 @@ namespace game {
 
 class Board;
 class BoardController;
+class BoardDelta;
 
 class Move;
 class Game;
@@ -36,6 +36,10 @@
 #include <atomic>
 #include <functional>
 #include <fstream>
+#include <cstdint>
+#include <bitset>
+#include <mutex>
+#include <type_traits>
 
 #include "piece.h"
 #include "../player/player.h"
@@ -45,6 +49,30 @@
 // The "game" namespace: See game.fwd.h
 namespace game {
 
+// The BoardDelta class: the squares changed by a single make (Board::doMove) or unmake (Board::undoMove)
+// A move touches at most 8 squares (from, to, castling rook, en passant pawn, cleared moved2x flags)
+class BoardDelta {
+  public:
+    class Change {
+      public:
+        int square;      // r * width + c
+        double old_code; // piece::Piece::code() before the change
+        double new_code; // piece::Piece::code() after the change
+    };
+
+    constexpr static int MAX_CHANGES = 8;
+
+    bool is_undo;
+    int move_count;                      // board move count after the change
+    int last_move_start, last_move_end;  // squares of the board's last move after the change (-1 if none)
+
+    int size;
+    Change changes[MAX_CHANGES];
+};
+
+// Called (on the thread making the move) after every make/unmake of the board it is registered on
+typedef std::function<void(const Board *, const BoardDelta &)> BoardListener;
+
 class Board : piece::PieceManager {
     friend class BoardController;
 
@@ -87,11 +115,22 @@ class Board : piece::PieceManager {
 
     void getMovesFromSquare(int r, int c, std::vector<game::Move> *moves);
     void getPossibleMoves(std::vector<game::Move> *white, std::vector<game::Move> *black);
+    void getCachedMoves(piece::PieceColor color, std::vector<game::Move> *moves); // checks game::MoveCache first
+
+    [[nodiscard]] inline uint64_t hash() const { return _hash; } // zobrist hash of the pieces (see zobrist.h)
+    [[nodiscard]] inline uint64_t pawnHash() const { return _pawn_hash; } // same, of the pawns only
 
     bool doMove(Move *move, Game *game); // See game::Move::doMove()
+    bool doMove(const Move &move, Game *game); // same, but the move is copied into a recycled slot -> no allocation
     void undoMove(Game *game, int depth = 1);
 
     [[nodiscard]] Move *getLastMove() const;
+    [[nodiscard]] inline const Move *peekLastMove() const { return _move_stack.empty() ? nullptr: _move_stack.top(); }
+    [[nodiscard]] std::vector<Move> moveHistory() const; // moves on the stack, oldest first
+
+    int addListener(const BoardListener &listener); // returns id for removeListener(...)
+    void removeListener(int listener_id);
+    void applyDelta(const BoardDelta &delta); // replay another board's delta onto a copy of it (no move history)
 
     [[nodiscard]] inline piece::PieceType pawn_upgrade_type() const { return _pawn_upgrade_type; }
     inline void set_pawn_upgrade_type(piece::PieceType type) { _pawn_upgrade_type = type; }
@@ -104,10 +143,43 @@ class Board : piece::PieceManager {
     void loadFromFile(const std::string &file_path,
                       const std::function<void(std::ifstream &)> &do_later = [](std::ifstream &in) -> void {});
 
+    // Forsyth-Edwards notation (8x8 only) -> castling rights && en passant become the king/rook/pawn flags
+    // false (&& the board is left as it was) if the fen is malformed or the position illegal (not one king per side,
+    // side that just moved in check), otherwise to_move is set to the side to move
+    bool loadFromFEN(const std::string &fen, piece::PieceColor *to_move);
+    [[nodiscard]] std::string toFEN(piece::PieceColor to_move) const;
+
     [[nodiscard]] int move_count() const { return _move_count.operator int(); }
 
-    double score(const std::function<double(piece::Piece *)> &piece_scorer) const;
-    double score(const std::function<double(piece::Piece *, int, int)> &piece_scorer) const;
+    // calls fn(piece, r, c) for every piece of the given color (both colors for NONE) -> empty squares are skipped
+    template<class Fn>
+    void forEachPiece(piece::PieceColor color, Fn &&fn) const {
+      for (int col = piece::PieceColor::BLACK; col <= piece::PieceColor::WHITE; ++col)
+        if (!color.isColored() || (piece::PieceColor::Color) color == col)
+          for (int square : _piece_lists[col])
+            fn(_pieces[square], square / _width, square % _width);
+    }
+    template<class Fn>
+    inline void forEachPiece(Fn &&fn) const { forEachPiece(piece::PieceColor::NONE, fn); }
+
+    [[nodiscard]] inline int pieceCount(piece::PieceColor color) const {
+      if (color.isColored())
+        return (int) _piece_lists[color].size();
+      return (int) (_piece_lists[piece::PieceColor::BLACK].size() + _piece_lists[piece::PieceColor::WHITE].size());
+    }
+
+    // sums piece_scorer(piece) or piece_scorer(piece, r, c) over the occupied squares
+    template<class Scorer>
+    double score(Scorer &&piece_scorer) const {
+      double score = 0;
+      forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+        if constexpr (std::is_invocable_v<Scorer, piece::Piece *, int, int>)
+          score += piece_scorer(piece, r, c);
+        else
+          score += piece_scorer(piece);
+      });
+      return score;
+    }
 
   private:
     std::atomic_int _move_count{0};
@@ -115,9 +187,31 @@ class Board : piece::PieceManager {
     int _width;
     std::vector<piece::Piece *> _pieces;
 
-    std::stack<Move *> _move_stack;
+    std::stack<Move *, std::vector<Move *>> _move_stack;
     piece::PieceType _pawn_upgrade_type{};
 
+    // undone moves && empty squares, kept for reuse -> make/unmake stops allocating once the stacks are warm
+    std::vector<Move *> _spare_moves;
+    std::vector<piece::Piece *> _spare_squares;
+    piece::Piece *takeEmptySquare();
+    void releaseEmptySquare(piece::Piece *square);
+
+    // per-square piece codes as of the last make/unmake -> diffed against the pieces to build deltas
+    std::vector<double> _codes;
+    uint64_t _hash, _pawn_hash;
+    void refreshCodes();
+
+    // squares occupied by each color (indexed by PieceColor) + each square's position in its list
+    std::vector<int> _piece_lists[2];
+    std::vector<int> _piece_list_index;
+    void updatePieceLists(int square, double old_code, double new_code);
+    void updateChangedSquares(const Move *move, bool is_undo);
+
+    std::map<int, BoardListener> _listeners;
+    std::atomic_int _listener_count{0};
+    int _next_listener_id;
+    std::mutex _listener_mutex;
+
     [[nodiscard]] constexpr int locMap(int r, int c) const {
       if (!isValidPosition(r, c)) {
         DEBUG_ASSERT
@@ -138,11 +232,12 @@ class BoardController {
 
     inline static std::vector<piece::Piece *> &getBoard(Board *board) { return board->_pieces; }
     inline static int locMap(Board *board, int r, int c) { return board->locMap(r, c); }
+    inline static piece::Piece *takeEmptySquare(Board *board) { return board->takeEmptySquare(); }
+    inline static void releaseEmptySquare(Board *board, piece::Piece *p) { board->releaseEmptySquare(p); }
 };
 
 class Move : BoardController, piece::PieceManager {
   public:
-    static std::vector<game::Move> getMoves(int r1, int c1, int r2, int c2, Board *b); // Array of Move Pointers
     Move(int r1, int c1, int r2, int c2, piece::PieceType promotionType);
 
     Move(const Move &m);
@@ -163,7 +258,7 @@ class Move : BoardController, piece::PieceManager {
              (_start_row == m._start_row && _start_col == m._start_col && _end_row == m._end_row &&
               _end_col < m._end_col) ||
              (_start_row == m._start_row && _start_col == m._start_col && _end_row == m._end_row &&
-              _end_col < m._end_col && _pawn_promotion_type.value() < m._pawn_promotion_type.value());
+              _end_col == m._end_col && _pawn_promotion_type.value() < m._pawn_promotion_type.value());
     }
     bool operator<=(const Move &m) const { return !(m < *this); }
     bool operator>(const Move &m) const { return m < *this; }
@@ -177,13 +272,20 @@ class Move : BoardController, piece::PieceManager {
 
     [[nodiscard]] inline piece::PieceType pawn_promotion_type() const { return _pawn_promotion_type; }
 
+    [[nodiscard]] uint16_t pack() const; // 6 bits start square, 6 bits end square, 3 bits promotion type
+    static Move unpack(uint16_t packed);
+
     bool verify(Board *board) const;
     bool isAttack(Board *board) const;
 
     bool doMove(Board *board); // true iff piece is captured
-    void undoMove(Board *board) const;
+    void undoMove(Board *board);
+
+    // squares changed by doMove/undoMove (only valid once the move was done) -> returns count
+    int changedSquares(Board *board, int squares[BoardDelta::MAX_CHANGES]) const;
 
     [[nodiscard]] std::string toString() const;
+    [[nodiscard]] std::string toLongAlgebraic() const; // ie "e2e4" or "e7e8q" (row 0 is rank 1, column 0 is file a)
 
   private:
     int _start_row, _start_col;
@@ -191,12 +293,23 @@ class Move : BoardController, piece::PieceManager {
 
     piece::PieceType _pawn_promotion_type{};
 
-    std::map<std::pair<int, int>, piece::Piece *> _other_replaced_pieces;
-    std::map<std::pair<int, int>, bool> _piece_setting_changes;
-
-    void addReplacedPiece(int r, int c, piece::Piece *p);
+    // state of a done move (pieces are handed back by undoMove) -> fixed size, only a promotion allocates
+    piece::Piece *_captured{};      // was on the end square (nullptr if it was empty)
+    piece::Piece *_promoted_pawn{}; // replaced by the promotion piece on the end square
+    piece::Piece *_passed_pawn{};   // taken en passant, from (start row, end column)
+    bool _castled{};                // rook moved too (king moved 2 columns)
+    bool _en_passant{};
+
+    class SettingChange {
+      public:
+        int row, col;
+        bool setting;
+    };
+    SettingChange _setting_changes[BoardDelta::MAX_CHANGES]{};
+    int _setting_change_count{};
 
     void addSettingChange(int r, int c, bool oldSetting);
+    void clearState(); // frees the pieces a done move took off the board
 
     static void updateSetting(Board *board, int r, int c, bool setting);
 };
@@ -236,8 +349,6 @@ class Game : BoardController, piece::PieceManager {
     void setPlayer(piece::PieceColor color, player::PlayerType type);
     void setGraphics(graphics::OpenGL *graphics);
 
-    void updateGraphicsBoard(Board *board);
-
     void startGame();
     void endGame();
     void waitForDelete() const;
@@ -252,9 +363,16 @@ class Game : BoardController, piece::PieceManager {
       _selected_y = -1;
     }
     void selectSquare(int x, int y);
+    [[nodiscard]] bool isLegalMove(const Move &move) const;
     bool tryMove(const Move &move);
+    void applyMove(const Move &move); // no validation -> only for moves taken from possibleMoves() (search, MCTS)
     void updateGameState();
 
+    // new position (see Board::loadFromFEN(...)), the side to move is the current player -> false if the fen is invalid
+    bool loadFromFEN(const std::string &fen);
+    // legal move of the current player in long algebraic notation (see Move::toLongAlgebraic()) -> false if none
+    bool findMove(const std::string &text, Move *move) const;
+
   private:
     Board *_board;
     graphics::OpenGL *_graphics;
@@ -271,6 +389,10 @@ class Game : BoardController, piece::PieceManager {
     std::vector<Move> _white_moves, _black_moves;
     void generatePossibleMoveVectors();
 
+    // legal (start square, end square) pairs of both colors, valid while the board's move count is unchanged
+    std::bitset<64 * 64> _legal_moves;
+    int _legal_moves_move_count;
+
     int _moves_since_last_capture;
 
     GameResult _result{};
@@ -0,0 +1,139 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "move_cache.h"
+
+#include <vector>
+
+int game::MoveCache::DEFAULT_SIZE_IN_MB = 16;
+
+game::MoveCache::MoveCache(int size_in_mb) {
+  if (size_in_mb <= 0) {
+    DEBUG_ASSERT
+    size_in_mb = 1;
+  }
+
+  // largest power of 2 that fits in the requested memory
+  std::size_t max_entries = ((std::size_t) size_in_mb << 20U) / sizeof(Entry);
+  _size = 1;
+  while (_size * 2 <= max_entries)
+    _size *= 2;
+
+  _entries = new Entry[_size];
+  _index_mask = _size - 1;
+}
+
+game::MoveCache::~MoveCache() {
+  delete[] _entries;
+}
+
+game::MoveCache *game::MoveCache::shared() {
+  static MoveCache cache(DEFAULT_SIZE_IN_MB);
+  return &cache;
+}
+
+long game::MoveCache::hits() const {
+  long hits = 0;
+  for (const CounterShard &shard : _counters)
+    hits += shard.hits.load(std::memory_order_relaxed);
+  return hits;
+}
+
+long game::MoveCache::misses() const {
+  long misses = 0;
+  for (const CounterShard &shard : _counters)
+    misses += shard.misses.load(std::memory_order_relaxed);
+  return misses;
+}
+
+game::MoveCache::CounterShard &game::MoveCache::counters(MoveCache *cache) {
+  static std::atomic_int next_shard{0};
+  thread_local int shard = next_shard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+  return cache->_counters[shard];
+}
+
+bool game::MoveCache::probe(uint64_t key, std::vector<Move> *moves) {
+  Entry &entry = _entries[key & _index_mask];
+
+  uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+  if ((sequence & 1U) || entry.key.load(std::memory_order_relaxed) != key) {
+    counters(this).misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // copy out first, only hand the moves over once we know no writer touched the entry meanwhile
+  uint16_t packed[MAX_CACHED_MOVES];
+  uint32_t count = entry.count.load(std::memory_order_relaxed), i;
+  if (count > MAX_CACHED_MOVES)
+    count = 0; // torn read -> caught by the sequence check below
+
+  for (i = 0; i < count; i += MOVES_PER_WORD) {
+    uint64_t word = entry.moves[i / MOVES_PER_WORD].load(std::memory_order_relaxed);
+    for (uint32_t j = 0; j < MOVES_PER_WORD; ++j)
+      packed[i + j] = (uint16_t) (word >> (16U * j));
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (entry.sequence.load(std::memory_order_relaxed) != sequence) {
+    counters(this).misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  for (i = 0; i < count; ++i)
+    moves->push_back(Move::unpack(packed[i]));
+
+  counters(this).hits.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void game::MoveCache::store(uint64_t key, const std::vector<Move> &moves, std::size_t first) {
+  if (first > moves.size()) {
+    DEBUG_ASSERT
+    return;
+  }
+
+  std::size_t count = moves.size() - first;
+  if (count > MAX_CACHED_MOVES)
+    return;
+
+  Entry &entry = _entries[key & _index_mask];
+
+  // claim the entry -> if another thread is writing it, just drop this store
+  uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+  if ((sequence & 1U) || !entry.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+    return;
+  std::atomic_thread_fence(std::memory_order_release); // pairs w/ the fence in probe(...)
+
+  entry.key.store(key, std::memory_order_relaxed);
+  entry.count.store((uint32_t) count, std::memory_order_relaxed);
+
+  for (std::size_t i = 0; i < count; i += MOVES_PER_WORD) {
+    uint64_t word = 0;
+    for (std::size_t j = 0; j < MOVES_PER_WORD && i + j < count; ++j)
+      word |= (uint64_t) moves[first + i + j].pack() << (16U * j);
+    entry.moves[i / MOVES_PER_WORD].store(word, std::memory_order_relaxed);
+  }
+
+  entry.sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,96 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_CHESS_MOVE_CACHE_H_
+#define CHESS_AI_CHESS_MOVE_CACHE_H_
+
+#include "move_cache.fwd.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+namespace game {
+
+// The MoveCache class: See move_cache.fwd.h
+// Entries are guarded by a per-entry sequence counter (a seqlock):
+//   - writers that find an entry mid-write simply skip storing (no thread ever waits)
+//   - readers that see the counter change while copying treat the probe as a miss
+// The cache never grows after construction, so memory is bounded by the size given on creation
+class MoveCache {
+  public:
+    MoveCache() = delete;
+    MoveCache(const MoveCache &mc) = delete;
+    MoveCache &operator=(const MoveCache &mc) = delete;
+
+    explicit MoveCache(int size_in_mb);
+    ~MoveCache();
+
+    static MoveCache *shared(); // process-wide cache shared by all games/threads
+
+    // appends the cached moves to moves -> true iff the position was found
+    bool probe(uint64_t key, std::vector<Move> *moves);
+    // caches moves[first...] under key
+    void store(uint64_t key, const std::vector<Move> &moves, std::size_t first = 0);
+
+    [[nodiscard]] long hits() const;   // summed over the counter shards
+    [[nodiscard]] long misses() const;
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    static int DEFAULT_SIZE_IN_MB;
+
+  private:
+    constexpr static int MAX_CACHED_MOVES = 128; // more moves than this -> position is not cached
+    constexpr static int MOVES_PER_WORD = 4;     // 4 16-bit packed moves per 64-bit word
+
+    class Entry {
+      public:
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint64_t> moves[MAX_CACHED_MOVES / MOVES_PER_WORD]{};
+    };
+
+    // every thread counts in its own shard (picked round robin on first use) -> no cache line is shared between
+    // the threads probing, as long as there are no more of them than shards
+    constexpr static int COUNTER_SHARDS = 16;
+
+    class alignas(64) CounterShard {
+      public:
+        std::atomic_long hits{0}, misses{0};
+    };
+
+    Entry *_entries;
+    std::size_t _size;
+    uint64_t _index_mask;
+
+    CounterShard _counters[COUNTER_SHARDS];
+    static CounterShard &counters(MoveCache *cache); // the calling thread's shard
+};
+
+}
+
+#endif // CHESS_AI_CHESS_MOVE_CACHE_H_
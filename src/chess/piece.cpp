@@ -26,6 +26,7 @@
 
 #include <string>
 #include <sstream>
+#include <cmath>
 
 #include "game.h"
 #include "../util/string_util.h"
@@ -282,6 +283,48 @@ piece::Piece *piece::PieceManager::getPieceOfTypeAndColor(PieceType t, PieceColo
   }
 }
 
+piece::Piece *piece::PieceManager::getPieceOfCode(double code) {
+  PieceColor c = code > 0 ? PieceColor::WHITE: PieceColor::BLACK;
+
+  // |code| = (type value + modified flag * value space) -> see PieceType::value()
+  switch (std::lround(std::abs(code) / PieceType::PIECE_TYPE_VALUE_SPACE)) {
+    case 0:
+      return new Piece();
+
+    case 1:
+    case 2: {
+      auto *king = new King(c);
+      update_flag(king, std::abs(code) > PieceType(PieceType::KING).value() + PieceType::PIECE_TYPE_VALUE_SPACE / 2);
+      return king;
+    }
+
+    case 3:
+      return new Queen(c);
+
+    case 4:
+    case 5: {
+      auto *rook = new Rook(c);
+      update_flag(rook, std::abs(code) > PieceType(PieceType::ROOK).value() + PieceType::PIECE_TYPE_VALUE_SPACE / 2);
+      return rook;
+    }
+
+    case 6:
+      return new Knight(c);
+
+    case 7:
+      return new Bishop(c);
+
+    case 8:
+    case 9: {
+      auto *pawn = new Pawn(c);
+      update_flag(pawn, std::abs(code) > PieceType(PieceType::PAWN).value() + PieceType::PIECE_TYPE_VALUE_SPACE / 2);
+      return pawn;
+    }
+
+    default: FATAL_ASSERT
+  }
+}
+
 // Piece to/from iostream
 namespace piece {
 
@@ -210,6 +210,7 @@ class PieceManager {
 
     static Piece *getPieceOfTypeAndColor(PieceType t, PieceColor c);
     static Piece *getPieceOfTypeAndColor(PieceType t, PieceColor c, bool mod);
+    static Piece *getPieceOfCode(double code); // inverse of Piece::code()
 
   protected:
     PieceManager() = default;
@@ -0,0 +1,112 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "zobrist.h"
+
+#include <array>
+#include <cmath>
+
+#include "piece.h"
+#include "game.h"
+
+namespace {
+
+// 9 piece states per color (see piece::PieceType::value()) + 1 empty state per color
+constexpr int NUM_STATES = 20;
+constexpr int NUM_SQUARES = 64;
+constexpr int PAWN_STATE = 8; // first of the 2 pawn states (8 && 9)
+
+// splitmix64 -> fixed seed so hashes are identical across runs (and across saved files)
+constexpr uint64_t next_key(uint64_t &seed) {
+  uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+
+struct KeyTable {
+  uint64_t pieces[NUM_STATES][NUM_SQUARES]{};
+  uint64_t colors[3]{};
+};
+
+constexpr KeyTable make_key_table() {
+  KeyTable table{};
+  uint64_t seed = 0x43686573732D4149ULL; // "Chess-AI"
+
+  for (int s = 0; s < NUM_STATES; ++s)
+    for (int i = 0; i < NUM_SQUARES; ++i)
+      table.pieces[s][i] = s % 10 == 0 ? 0: next_key(seed); // empty squares don't change the hash
+
+  table.colors[piece::PieceColor::BLACK] = next_key(seed);
+  table.colors[piece::PieceColor::WHITE] = next_key(seed);
+  table.colors[piece::PieceColor::NONE] = 0;
+  return table;
+}
+
+constexpr KeyTable KEYS = make_key_table();
+
+}
+
+int zobrist::state_index(double piece_code) {
+  // |code| is a multiple of PIECE_TYPE_VALUE_SPACE (0 for empty) -> 0-9, then offset white codes by 10
+  int state = (int) std::lround(std::abs(piece_code) / piece::PieceType::PIECE_TYPE_VALUE_SPACE);
+  return piece_code > 0 ? state + 10: state;
+}
+
+uint64_t zobrist::key(double piece_code, int square) {
+  if (square < 0 || square >= NUM_SQUARES) {
+    DEBUG_ASSERT
+    return 0;
+  }
+  return KEYS.pieces[state_index(piece_code)][square];
+}
+
+uint64_t zobrist::color_key(piece::PieceColor color) {
+  return KEYS.colors[color];
+}
+
+uint64_t zobrist::hash(const game::Board *board) {
+  uint64_t hash = 0;
+  int r, c;
+  for (r = 0; r < board->length(); ++r)
+    for (c = 0; c < board->width(); ++c)
+      hash ^= key(board->getPiece(r, c)->code(), r * board->width() + c);
+  return hash;
+}
+
+uint64_t zobrist::pawn_key(double piece_code, int square) {
+  int state = state_index(piece_code);
+  if (state % 10 < PAWN_STATE || square < 0 || square >= NUM_SQUARES)
+    return 0;
+  return KEYS.pieces[state - state % 10 + PAWN_STATE][square];
+}
+
+uint64_t zobrist::pawn_hash(const game::Board *board) {
+  uint64_t hash = 0;
+  int r, c;
+  for (r = 0; r < board->length(); ++r)
+    for (c = 0; c < board->width(); ++c)
+      hash ^= pawn_key(board->getPiece(r, c)->code(), r * board->width() + c);
+  return hash;
+}
@@ -0,0 +1,58 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_CHESS_ZOBRIST_H_
+#define CHESS_AI_CHESS_ZOBRIST_H_
+
+#include <cstdint>
+
+#include "piece.fwd.h"
+#include "game.fwd.h"
+
+// The "zobrist" namespace holds the position hashing keys used by the transposition-style caches
+//   - Each (piece state, square) pair gets its own random 64-bit key
+//   - A piece's state is read straight from piece::Piece::code(), so moved/moved2x flags are hashed too
+namespace zobrist {
+
+// piece code (see piece::Piece::code()) -> index into the key table
+int state_index(double piece_code);
+
+// key for a piece with the given code on the given square index
+uint64_t key(double piece_code, int square);
+
+// key for the side whose moves are being looked up/searched
+uint64_t color_key(piece::PieceColor color);
+
+// full recomputation of the board hash (pieces only -> xor in color_key(...) for the side to move)
+uint64_t hash(const game::Board *board);
+
+// key for the piece if it is a pawn (0 otherwise) -> both pawn states share a key, only color && square matter
+uint64_t pawn_key(double piece_code, int square);
+
+// full recomputation of the pawn-only hash (see game::Board::pawnHash())
+uint64_t pawn_hash(const game::Board *board);
+
+}
+
+#endif // CHESS_AI_CHESS_ZOBRIST_H_
@@ -62,6 +62,15 @@ graphics::OpenGL::OpenGL(game::Game *game, const std::string &game_name) {
   _game = game;
   _board = game->board()->clone();
 
+  game::Move *last_move = _board->getLastMove();
+  _last_move_start = last_move == nullptr ? -1: locMap(_board, last_move->startingRow(), last_move->startingColumn());
+  _last_move_end = last_move == nullptr ? -1: locMap(_board, last_move->endingRow(), last_move->endingColumn());
+  delete last_move;
+
+  _board_listener_id = game->board()->addListener(
+    [this](const game::Board *, const game::BoardDelta &delta) -> void { queueBoardDelta(delta); }
+  );
+
   asset_file_path = ASSET_2D_DIRECTORY;
 
   _white = game->white_player();
@@ -86,6 +95,7 @@ graphics::OpenGL::OpenGL(game::Game *game, const std::string &game_name) {
 }
 
 graphics::OpenGL::~OpenGL() {
+  _game->board()->removeListener(_board_listener_id);
   _opengl_map.erase(_window);
   delete _board; // -> b/c it's a clone
 
@@ -316,23 +326,24 @@ void graphics::OpenGL::initialize() {
   _texture_samplerID = glGetUniformLocation(_shader_programID, "texture_sampler");
 }
 
-void graphics::OpenGL::updateGraphics(game::Board *board) {
-  if (board == nullptr) {
-    DEBUG_ASSERT
-    return;
-  }
-
-  delete _temp_board;
-  _temp_board = board->clone();
+void graphics::OpenGL::queueBoardDelta(const game::BoardDelta &delta) {
+  std::lock_guard<std::mutex> lock(_delta_mutex);
+  _pending_deltas.push_back(delta);
 }
 
 void graphics::OpenGL::checkBoardUpdate() {
-  if (_temp_board == nullptr)
-    return;
+  std::vector<game::BoardDelta> deltas;
+  {
+    std::lock_guard<std::mutex> lock(_delta_mutex);
+    deltas.swap(_pending_deltas);
+  }
 
-  delete _board;
-  _board = _temp_board;
-  _temp_board = nullptr;
+  // only the (at most 8) changed squares of each move are rebuilt
+  for (const game::BoardDelta &delta: deltas) {
+    _board->applyDelta(delta);
+    _last_move_start = delta.last_move_start;
+    _last_move_end = delta.last_move_end;
+  }
 }
 
 void graphics::OpenGL::renderOverlays(GLuint textbuff) {
@@ -342,22 +353,22 @@ void graphics::OpenGL::renderOverlays(GLuint textbuff) {
     _overlays[locMap(_board, x, y)][0] = true;
 
     // attack squares if extra ui enabled
-    if (_show_expanded_ui) {
+    piece::PieceColor color = _board->getPiece(x, y)->color();
+    if (_show_expanded_ui && color.isColored()) {
       auto *moves = new std::vector<game::Move>();
-      _board->getMovesFromSquare(x, y, moves);
+      _board->getCachedMoves(color, moves);
       for (const game::Move &move: *moves)
-        _overlays[locMap(_board, move.endingRow(), move.endingColumn())][2 + move.isAttack(_board)] = true;
+        if (move.startingRow() == x && move.startingColumn() == y)
+          _overlays[locMap(_board, move.endingRow(), move.endingColumn())][2 + move.isAttack(_board)] = true;
       delete moves;
     }
   }
 
   // previous move overlay
-  game::Move *pastMove = _board->getLastMove();
-  if (pastMove != nullptr) {
-    _overlays[locMap(_board, pastMove->startingRow(), pastMove->startingColumn())][1] = true;
-    _overlays[locMap(_board, pastMove->endingRow(), pastMove->endingColumn())][1] = true;
+  if (_last_move_start != -1 && _last_move_end != -1) {
+    _overlays[_last_move_start][1] = true;
+    _overlays[_last_move_end][1] = true;
   }
-  delete pastMove;
 
   std::string total, filePath;
   std::string textures[4] = {"selected", "previous_move", "normal_move", "attacking_move"};
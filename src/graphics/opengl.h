@@ -34,6 +34,8 @@
 
 #include <map>
 #include <string>
+#include <vector>
+#include <mutex>
 
 #include "shader.h"
 
@@ -52,8 +54,6 @@ class OpenGL : game::BoardController {
 
     void run();
 
-    void updateGraphics(game::Board *board);
-
   private:
     static std::map<GLFWwindow *, OpenGL *> _opengl_map;
 
@@ -99,7 +99,13 @@ class OpenGL : game::BoardController {
     game::Game *_game;
     game::Board *_board;
 
-    game::Board *_temp_board;
+    // _board is a render-thread snapshot of the game board, kept in sync through board deltas
+    int _board_listener_id;
+    std::mutex _delta_mutex;
+    std::vector<game::BoardDelta> _pending_deltas;
+    int _last_move_start, _last_move_end;
+
+    void queueBoardDelta(const game::BoardDelta &delta);
     void checkBoardUpdate();
 
     player::Player *_white;
@@ -24,13 +24,22 @@
 
 #include "main/initialization.h"
 #include "main/run_game.h"
+#include "main/uci.h"
 #include "main/network/make_cases.h"
 #include "main/network/train.h"
 
 #include <thread>
 
+#include "chess/game.h"
 #include "mcts_network/tree.h"
+#include "player/player.h"
+#include "player/search.h"
+#include "player/time_manager.h"
+#include "player/tablebase.h"
+#include "player/batch_analysis.h"
+#include "player/mate_search.h"
 #include "util/thread_util.h"
+#include "util/string_util.h"
 
 // command line arguments
 char **arguments;
@@ -39,6 +48,12 @@ int num_args;
 // create termination lambda variables
 int game_count = 0, end_count = 500; // end_count = how many games to simulate for training before exiting the program
 
+// Command line: <working directory> uci -> the program is a headless UCI engine (see uci::Session)
+// stdout then belongs to the protocol, so none of the usual output is printed
+bool isUCIMode() {
+  return num_args >= 2 && std::string(arguments[1]) == "uci";
+}
+
 // The initialize() method initializes all of the different modules of this program
 // and ensures that all necessary preconditions are met.
 //
@@ -46,8 +61,8 @@ int game_count = 0, end_count = 500; // end_count = how many games to simulate f
 // the program believes that it is ready to run any of its features, including but
 // not limited to training the network and playing a game with graphics (using OpenGL).
 void initialize(const std::function<bool()> &termination_condition = [] { return true; }) {
-  settings::PRINT_INITIALIZATION_DEBUG_INFORMATION = true;
-  settings::PRINT_GAME_SIMULATION_DEBUG_INFORMATION = true;
+  settings::PRINT_INITIALIZATION_DEBUG_INFORMATION = !isUCIMode();
+  settings::PRINT_GAME_SIMULATION_DEBUG_INFORMATION = !isUCIMode();
 
   // Update current working directory
   num_args <= 0 ? init::updateWorkingDirectory(): init::updateWorkingDirectory(arguments[0]);
@@ -60,17 +75,55 @@ void initialize(const std::function<bool()> &termination_condition = [] { return
   // param 3: (int) number of search iterations (MCTS) - default = 125 iterations
   init::updateMCTSParameters(0.40, 8, 150);
 
+  // param 1: (int) transposition table size per alpha-beta player, in MB - default = 32 MB
+  // param 2: (double) game clock per minimax/alpha-beta player, in seconds - default = 600 s
+  // param 3: (double) clock increment per move, in seconds - default = 5 s
+  // param 4: (int) search threads per alpha-beta player (lazy smp) - default = 1 thread
+  // param 5: (bool) print search statistics (nodes, nps, cutoffs, pv...) for each alpha-beta move - default = false
+  init::updateMinimaxParameters();
+  // param 1: (bool) null move pruning in alpha-beta search - default = true
+  // param 2: (bool) late move reductions in alpha-beta search - default = true
+  // param 3: (bool) futility pruning at frontier nodes in alpha-beta search - default = true
+  init::updateSelectiveSearchParameters();
+  // param 1: (long) nodes per move (alpha-beta) or simulations per move (mcts) - default = 0 = no limit
+  // param 2: (int) depth per move, in half-moves (alpha-beta) - default = 0 = player default (4 or 6)
+  // param 3: (double) fixed time per move, in seconds -> overrides the clock - default = 0 = use the clock
+  // param 4: (double) game clock of every computer player, in seconds - default = 0 = minimax clock above
+  // param 5: (double) clock increment per move, in seconds - default = 0 s
+  // -> the default depth (alpha-beta) && simulation count (mcts) only apply if no node count/time/clock is set
+  init::updateSearchLimitParameters();
+  // param 1: (bool) alpha-beta players search the expected reply on the opponent's time - default = true
+  // param 2: (bool) mcts players search the expected reply on the opponent's time - default = true
+  init::updatePonderingParameters();
+  // param 1: (bool) alpha-beta threads split the root moves -> same input, same move && node count - default = false
+  // param 2: (bool) mcts threads run fixed shares of the simulations w/ fixed seeds - default = false
+  // param 3: (unsigned long) seed of the deterministic mcts root noise - default = 0
+  // -> both ignore the clock (only nodes/depth/simulations stop the search) && turn pondering off
+  init::updateDeterministicSearchParameters();
+  // param 1: (long) nodes of proof-number mate search before each mcts move -> 0 = no mate search - default = 0
+  // param 2: (int) longest mate the mcts players look for, in moves - default = 3 moves
+  // param 3: (int) mate search table size, in MB - default = 16 MB
+  init::updateMateSearchParameters();
+  // param 1: (string) directory w/ endgame tables (*.tb) -> none are probed if it is empty - default = "tablebases"
+  init::updateTablebaseParameters();
+  // param 1: (string) opening book file path -> no book if the file is missing - default = "assets/opening_book.bin"
+  // param 2: (OpeningBook::Policy) how book moves are picked (BEST or WEIGHTED_RANDOM) - default = WEIGHTED_RANDOM
+  // param 3: (string) file to append finished games to (to build books from) - default = "" = don't save games
+  init::updateOpeningBookParameters();
+
   // param 1: (bool) load previous network from file - default = true
   // param 2: (bool) save trained networks to files - default = true
   // param 3: (string) file path to previous network - default = "network_dump/latest.txt"
   init::updateNetworkSettings();
+  // param 1: (int) leaf positions evaluated per forward pass by the network alpha-beta players - default = 4
+  init::updateNetworkSearchParameters();
   // param 1: (lambda) when to terminate program training - default = return true; = do not train
   // param 2: (int) network training save interval - default = 20 iterations
   // param 3: (double) ratio of boards from simulations to save - default = 100% saved
   init::updateTrainingParameters(termination_condition, 100, 0.1);
   // for this ^^ (lambda), remember that counter vars need to remain existent after this method's execution finishes
   // ie make sure the counters aren't local variables or uNdEfInEd BeHaViOr....
-  if (!settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
+  if (!settings::PRINT_INITIALIZATION_DEBUG_INFORMATION && !isUCIMode()) // uci -> stdout is the protocol only
     std::cout << "Program Initialization Complete!" << std::endl << std::endl;
 }
 
@@ -114,6 +167,92 @@ void execute_training() {
   std::cout << "Program Execution Complete!!" << std::endl << std::endl;
 }
 
+void execute_opening_book_build(const std::string &game_record_file_path = "game_records.txt",
+                                const std::string &book_file_path = "assets/opening_book.bin",
+                                int max_ply = 20, int min_games = 2) {
+  player::OpeningBookBuilder builder(max_ply, min_games);
+  int games = builder.addGameRecords(game_record_file_path);
+  long entries = builder.write(book_file_path);
+  std::cout << "Opening Book: " << games << " games -> " << entries << " entries (\"" << book_file_path << "\")"
+            << std::endl << std::endl;
+}
+
+void execute_tablebase_generation(const std::vector<std::string> &materials = {"KQvK", "KRvK", "KPvK", "KBNvK"},
+                                  const std::string &tablebase_directory = "tablebases") {
+  // tables that are already there are kept -> only missing ones (&& what they depend on) are generated
+  auto *tables = new player::Tablebases(tablebase_directory);
+  player::TablebaseGenerator generator(tables, tablebase_directory, (int) std::thread::hardware_concurrency());
+  for (const std::string &material : materials)
+    if (!generator.generate(material))
+      std::cout << "Tablebase " << material << " could not be generated" << std::endl;
+  std::cout << std::endl;
+
+  // switch the searches over to the new tables
+  delete player::Tablebases::LOADED;
+  player::Tablebases::LOADED = tables;
+}
+
+void execute_analysis(const std::string &board_file_path = "assets/game_states/chess_default_start.txt",
+                      int num_lines = 3, double seconds_per_position = 10.0) {
+  auto *game = new game::Game(8, 8);
+  game->board()->loadFromFile(board_file_path);
+  game->updateGameState();
+
+  // same engine as the alpha-beta player, but every one of the num_lines best moves gets its own line
+  player::SearchConfig config = player::AlphaBetaPlayer::searchConfig();
+  config.multi_pv = num_lines;
+  player::SearchEngine engine(config);
+  player::SearchLimits limits;
+  limits.movetime = seconds_per_position;
+  player::TimeManager time_manager(0.0, 0.0);
+  time_manager.startMove(limits);
+  engine.search(game->board(), game->getCurrentColor(), limits, &time_manager, [] { return false; });
+
+  std::cout << "Analysis of \"" << board_file_path << "\" (depth " << engine.lastSearchStatistics().depth << ", "
+            << engine.lastSearchNodes() << " nodes):" << std::endl;
+  int rank = 0;
+  for (const player::SearchLine &line : engine.lastSearchLines()) {
+    std::cout << ++rank << ". score " << line.score << ", pv";
+    for (const game::Move &move : line.moves)
+      std::cout << " " << move.toString();
+    std::cout << std::endl;
+  }
+  std::cout << std::endl;
+
+  delete game;
+}
+
+// positions file -> one FEN per line or player::PositionFile records, results -> see BatchAnalyzer::writeResult(...)
+// 0 = no limit for depth/nodes/movetime (if all 3 are 0, the alpha-beta player's max_depth bounds each search)
+void execute_batch_analysis(const std::string &positions_file_path, const std::string &output_file_path,
+                            int num_threads = (int) std::thread::hardware_concurrency(), int max_depth = 0,
+                            long max_nodes = 0, double movetime = 0.0) {
+  player::SearchLimits limits;
+  limits.depth = max_depth;
+  limits.nodes = max_nodes;
+  limits.movetime = movetime;
+
+  player::BatchAnalyzer analyzer(player::AlphaBetaPlayer::searchConfig(), limits, std::max(num_threads, 1));
+  if (analyzer.run(positions_file_path, output_file_path) < 0)
+    std::cout << "Could not analyze \"" << positions_file_path << "\" into \"" << output_file_path << "\""
+              << std::endl << std::endl;
+}
+
+// shortest forced mate for the side to move -> max_nodes = 0 = no limit (the search ends at max_moves anyway)
+void execute_mate_search(const std::string &fen, int max_moves = 5, long max_nodes = 0) {
+  game::Board board(8, 8);
+  piece::PieceColor color;
+  if (!board.loadFromFEN(fen, &color)) {
+    std::cout << "Invalid position \"" << fen << "\"" << std::endl << std::endl;
+    return;
+  }
+
+  player::MateSearch mate_search(player::MateSearch::DEFAULT_SIZE_IN_MB);
+  player::MateSearch::Result result = mate_search.search(&board, color, max_moves, max_nodes);
+  std::cout << "Mate search of \"" << fen << "\" (up to " << max_moves << " moves): " << result.toString()
+            << std::endl << std::endl;
+}
+
 void execute_gameplay(player::PlayerType white = player::PlayerType::HUMAN,
                       player::PlayerType black = player::PlayerType::AI) {
   std::cout << "Starting Game" << std::endl << std::endl;
@@ -131,8 +270,28 @@ void execute_gameplay(player::PlayerType white = player::PlayerType::HUMAN,
 //
 // There is also a planned UI which will allow users to select configurations while the
 // program is running. However, this is not a high-priority feature.
+//
+// Command line: <working directory> analyze <positions> <output> [threads] [depth] [nodes] [movetime]
+// runs a headless batch analysis instead (see execute_batch_analysis(...)), && <working directory> mate "<fen>"
+// [max moves] [nodes] a mate search (see execute_mate_search(...))
 void execute() {
+  if (num_args >= 4 && std::string(arguments[1]) == "analyze") {
+    execute_batch_analysis(arguments[2], arguments[3],
+                           num_args > 4 ? std::stoi(arguments[4]): (int) std::thread::hardware_concurrency(),
+                           num_args > 5 ? std::stoi(arguments[5]): 0, num_args > 6 ? std::stol(arguments[6]): 0,
+                           num_args > 7 ? string::to_double(arguments[7]): 0.0);
+    return;
+  }
+  if (num_args >= 3 && std::string(arguments[1]) == "mate") {
+    execute_mate_search(arguments[2], num_args > 3 ? std::stoi(arguments[3]): 5,
+                        num_args > 4 ? std::stol(arguments[4]): 0);
+    return;
+  }
+
   execute_training();
+//  execute_opening_book_build();
+//  execute_tablebase_generation();
+//  execute_analysis();
 //  execute_gameplay(player::PlayerType::AI, player::PlayerType::HUMAN); // white, black
 }
 
@@ -144,8 +303,13 @@ void execute() {
 //
 // This method can be thought of as the inverse of the initialize() method.
 void terminate() {
-  std::cout << "Releasing remaining allocated memory..." << std::endl << std::endl;
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
+    std::cout << "Releasing remaining allocated memory..." << std::endl << std::endl;
   network::NetworkStorage::flushStorage(); // delete any stored networks
+  delete player::Player::OPENING_BOOK;
+  player::Player::OPENING_BOOK = nullptr;
+  delete player::Tablebases::LOADED;
+  player::Tablebases::LOADED = nullptr;
 }
 
 void printSpacing(int front, int end, std::ostream &out = std::cout) {
@@ -164,6 +328,15 @@ int main(int len, char **args) {
   arguments = args + 1;
   num_args = len - 1;
 
+  // uci engine -> no graphics, no training, nothing printed but the protocol
+  if (isUCIMode()) {
+    initialize();
+    if (init::verify())
+      uci::run(std::cin, std::cout);
+    terminate();
+    return 0;
+  }
+
   // initialize, run, and close program
   printSpacing(1, 2);
   initialize([&] { return game_count >= end_count; });
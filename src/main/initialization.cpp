@@ -39,14 +39,23 @@
 #include <cmath>
 #include <functional>
 #include <utility>
+#include <random>
 
 #include "../mcts_network/tree.h"
+#include "../chess/bitboard.h"
+#include "../player/transposition_table.h"
+#include "../player/time_manager.h"
+#include "../player/search.h"
+#include "../player/player.h"
+#include "../player/tablebase.h"
+#include "../player/mate_search.h"
 
 // extern variables
 bool settings::PRINT_INITIALIZATION_DEBUG_INFORMATION = true;
 bool settings::PRINT_GAME_SIMULATION_DEBUG_INFORMATION = false;
 
 int settings::GAMES_PER_NETWORK_SAVE = -1;
+std::string settings::GAME_RECORD_FILE_PATH;
 
 std::function<bool()> settings::TRAINING_TERMINATION_CONDITION;
 std::function<void(std::vector<std::pair<game::Board *, double>> &, game::Board *, double)>
@@ -178,6 +187,171 @@ void init::updateMCTSParameters(double thread_usage_ratio, int simulation_move_d
   printNewLine();
 }
 
+void init::updateMinimaxParameters(int transposition_table_size_in_mb, double clock_in_seconds,
+                                   double increment_in_seconds, int alpha_beta_threads,
+                                   bool print_search_information) {
+  player::TranspositionTable::DEFAULT_SIZE_IN_MB = std::max(transposition_table_size_in_mb, 1);
+  player::TimeManager::DEFAULT_CLOCK_IN_SECONDS = std::max(clock_in_seconds, 0.0);
+  player::TimeManager::DEFAULT_INCREMENT_IN_SECONDS = std::max(increment_in_seconds, 0.0);
+  player::AlphaBetaPlayer::DEFAULT_NUM_THREADS = std::max(alpha_beta_threads, 1);
+  player::AlphaBetaPlayer::PRINT_SEARCH_INFORMATION = print_search_information;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    std::cout << "Alpha-Beta Transposition Table Size: " << player::TranspositionTable::DEFAULT_SIZE_IN_MB << " MB"
+              << std::endl;
+    std::cout << "Minimax Player Clock: " << player::TimeManager::DEFAULT_CLOCK_IN_SECONDS << " s + "
+              << player::TimeManager::DEFAULT_INCREMENT_IN_SECONDS << " s per move" << std::endl;
+    std::cout << "Alpha-Beta Search Threads: " << player::AlphaBetaPlayer::DEFAULT_NUM_THREADS << std::endl;
+  }
+
+  printNewLine();
+}
+
+void init::updateSelectiveSearchParameters(bool null_move_pruning, bool late_move_reductions, bool futility_pruning) {
+  player::AlphaBetaPlayer::USE_NULL_MOVE_PRUNING = null_move_pruning;
+  player::AlphaBetaPlayer::USE_LATE_MOVE_REDUCTIONS = late_move_reductions;
+  player::AlphaBetaPlayer::USE_FUTILITY_PRUNING = futility_pruning;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    std::cout << std::boolalpha;
+    std::cout << "Alpha-Beta Null Move Pruning: " << null_move_pruning << std::endl;
+    std::cout << "Alpha-Beta Late Move Reductions: " << late_move_reductions << std::endl;
+    std::cout << "Alpha-Beta Futility Pruning: " << futility_pruning << std::endl;
+    std::cout << std::noboolalpha;
+  }
+
+  printNewLine();
+}
+
+void init::updateSearchLimitParameters(long max_nodes, int max_depth, double movetime_in_seconds,
+                                       double clock_in_seconds, double increment_in_seconds) {
+  player::SearchLimits limits;
+  limits.nodes = std::max(max_nodes, 0L);
+  limits.depth = std::max(max_depth, 0);
+  limits.movetime = std::max(movetime_in_seconds, 0.0);
+  limits.clock = std::max(clock_in_seconds, 0.0);
+  limits.increment = std::max(increment_in_seconds, 0.0);
+  player::Player::DEFAULT_SEARCH_LIMITS = limits;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    std::cout << "Search Node Limit: " << (limits.nodes > 0 ? std::to_string(limits.nodes): "none") << std::endl;
+    std::cout << "Search Depth Limit: " << (limits.depth > 0 ? std::to_string(limits.depth): "player default")
+              << std::endl;
+    if (limits.movetime > 0.0)
+      std::cout << "Search Time: " << limits.movetime << " s per move" << std::endl;
+    else if (limits.clock > 0.0)
+      std::cout << "Search Clock: " << limits.clock << " s + " << limits.increment << " s per move" << std::endl;
+    else
+      std::cout << "Search Time: player default" << std::endl;
+  }
+
+  printNewLine();
+}
+
+void init::updatePonderingParameters(bool alpha_beta_pondering, bool mcts_pondering) {
+  player::AlphaBetaPlayer::PONDERING = alpha_beta_pondering;
+  player::MonteCarloPlayer::PONDERING = mcts_pondering;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    std::cout << std::boolalpha;
+    std::cout << "Alpha-Beta Pondering: " << alpha_beta_pondering << std::endl;
+    std::cout << "MCTS Pondering: " << mcts_pondering << std::endl;
+    std::cout << std::noboolalpha;
+  }
+
+  printNewLine();
+}
+
+void init::updateDeterministicSearchParameters(bool alpha_beta_deterministic, bool mcts_deterministic,
+                                               unsigned long mcts_seed) {
+  player::AlphaBetaPlayer::DETERMINISTIC = alpha_beta_deterministic;
+  tree::MCTS::DETERMINISTIC = mcts_deterministic;
+  tree::MCTS::SEED = mcts_seed;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    std::cout << std::boolalpha;
+    std::cout << "Deterministic Alpha-Beta Search: " << alpha_beta_deterministic << std::endl;
+    std::cout << "Deterministic MCTS: " << mcts_deterministic;
+    if (mcts_deterministic)
+      std::cout << " (seed " << mcts_seed << ")";
+    std::cout << std::endl;
+    std::cout << std::noboolalpha;
+  }
+
+  printNewLine();
+}
+
+void init::updateMateSearchParameters(long mcts_mate_search_nodes, int mcts_mate_search_moves, int table_size_in_mb) {
+  player::MonteCarloPlayer::MATE_SEARCH_NODES = std::max(mcts_mate_search_nodes, 0L);
+  player::MonteCarloPlayer::MATE_SEARCH_MOVES = std::min(std::max(mcts_mate_search_moves, 1),
+                                                         (int) player::MateSearch::MAX_MOVES);
+  player::MateSearch::DEFAULT_SIZE_IN_MB = std::max(table_size_in_mb, 1);
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    if (player::MonteCarloPlayer::MATE_SEARCH_NODES > 0)
+      std::cout << "MCTS Mate Search: mates in up to " << player::MonteCarloPlayer::MATE_SEARCH_MOVES << " moves, "
+                << player::MonteCarloPlayer::MATE_SEARCH_NODES << " nodes per move" << std::endl;
+    else
+      std::cout << "MCTS Mate Search: off" << std::endl;
+    std::cout << "Mate Search Table Size: " << player::MateSearch::DEFAULT_SIZE_IN_MB << " MB" << std::endl;
+  }
+
+  printNewLine();
+}
+
+void init::updateTablebaseParameters(const std::string &tablebase_directory) {
+  delete player::Tablebases::LOADED;
+  player::Tablebases::LOADED = nullptr;
+
+  auto *tables = new player::Tablebases(tablebase_directory);
+  if (tables->size() > 0)
+    player::Tablebases::LOADED = tables;
+  else
+    delete tables;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    if (player::Tablebases::LOADED != nullptr)
+      std::cout << "Endgame Tablebases: " << player::Tablebases::LOADED->size() << " tables (up to "
+                << player::Tablebases::LOADED->maxPieces() << " pieces) from \"" << tablebase_directory << "\""
+                << std::endl;
+    else
+      std::cout << "Endgame Tablebases: none (no tables in \"" << tablebase_directory << "\")" << std::endl;
+  }
+
+  printNewLine();
+}
+
+void init::updateOpeningBookParameters(const std::string &book_file_path, player::OpeningBook::Policy policy,
+                                       const std::string &game_record_file_path) {
+  delete player::Player::OPENING_BOOK;
+  player::Player::OPENING_BOOK = nullptr;
+
+  auto *book = new player::OpeningBook(book_file_path, policy);
+  if (book->isOpen())
+    player::Player::OPENING_BOOK = book;
+  else
+    delete book;
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    if (player::Player::OPENING_BOOK != nullptr)
+      std::cout << "Opening Book: \"" << book_file_path << "\" (" << player::Player::OPENING_BOOK->size()
+                << " entries, " << (policy == player::OpeningBook::BEST ? "best": "weighted random") << " moves)"
+                << std::endl;
+    else
+      std::cout << "Opening Book: none (\"" << book_file_path << "\" not found)" << std::endl;
+  }
+
+  settings::GAME_RECORD_FILE_PATH = game_record_file_path;
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
+    if (game_record_file_path.empty())
+      std::cout << "Game records will NOT be saved" << std::endl;
+    else
+      std::cout << "Game records will be saved to \"" << game_record_file_path << "\"" << std::endl;
+  }
+
+  printNewLine();
+}
+
 void init::updateNetworkSettings(bool load_prev_net, bool save_net, const std::string &net_file_path) {
   if (load_prev_net) {
     if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
@@ -200,6 +374,16 @@ void init::updateNetworkSettings(bool load_prev_net, bool save_net, const std::s
   printNewLine();
 }
 
+void init::updateNetworkSearchParameters(int alpha_beta_batch_size) {
+  player::NetworkAlphaBetaPlayer::NETWORK_BATCH_SIZE = std::max(alpha_beta_batch_size, 1);
+
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
+    std::cout << "Network Alpha-Beta Batch Size: " << player::NetworkAlphaBetaPlayer::NETWORK_BATCH_SIZE
+              << " positions per forward pass" << std::endl;
+
+  printNewLine();
+}
+
 void print(const std::string &desc, int val, const std::string &unit, bool putS = true, std::ostream &out = std::cout) {
   if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION) {
     out << desc << ": " << val << " " << unit;
@@ -231,6 +415,50 @@ void init::updateTrainingParameters(const std::function<bool()> &termination_con
   printNewLine();
 }
 
+// positions reached by random playouts from a few fens (castling, en passant && promotions included) -> checked by
+// bitboard::verify(...), returns the number of mismatches && sets position_count
+static int verifyBitboardKernel(int *position_count) {
+  static const int PLAYOUTS = 8, PLIES = 60;
+  const std::string fens[] = {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                              "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                              "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                              "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                              "8/8/8/2k5/3Pp3/8/8/K7 b - d3 0 1"};
+
+  std::mt19937 rng(0); // own generator -> same positions every run, program rng left alone
+  bitboard::PositionBatch batch;
+  std::vector<game::Board *> boards;
+  std::vector<game::Move> moves;
+  for (const std::string &fen : fens)
+    for (int playout = 0; playout < PLAYOUTS; ++playout) {
+      game::Board board(8, 8);
+      piece::PieceColor to_move;
+      if (!board.loadFromFEN(fen, &to_move)) {
+        DEBUG_ASSERT
+        continue;
+      }
+      board.set_pawn_upgrade_type(piece::PieceType::QUEEN);
+
+      for (int ply = 0; ply < PLIES; ++ply, to_move = !to_move) {
+        batch.add(&board, to_move);
+        boards.push_back(board.clone());
+
+        moves.clear();
+        board.getCachedMoves(to_move, &moves);
+        if (moves.empty())
+          break;
+        board.doMove(moves[rng() % moves.size()], nullptr);
+      }
+    }
+
+  int mismatches = bitboard::verify(batch, boards);
+  for (auto &board : boards)
+    delete board;
+
+  *position_count = batch.size();
+  return mismatches;
+}
+
 bool init::verify(bool is_fatal_if_fail) {
   if (network::NetworkStorage::current_network() == nullptr) {
     if (is_fatal_if_fail) FATAL_ASSERT
@@ -264,6 +492,16 @@ bool init::verify(bool is_fatal_if_fail) {
   if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
     std::cout << "Training can terminate safely" << std::endl;
 
+  int position_count;
+  if (verifyBitboardKernel(&position_count) != 0) {
+    if (is_fatal_if_fail) FATAL_ASSERT
+    else DEBUG_ASSERT
+    return false;
+  }
+  if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
+    std::cout << "Bitboard kernels (" << (bitboard::hasAVX2() ? "scalar and AVX2": "scalar")
+              << ") match the move generator on " << position_count << " positions" << std::endl;
+
   if (settings::PRINT_INITIALIZATION_DEBUG_INFORMATION)
     std::cout << "Program is ready to simulate games" << std::endl;
 
@@ -29,6 +29,7 @@
 #include <functional>
 
 #include "../mcts_network/network.h"
+#include "../player/opening_book.h"
 
 namespace settings {
 
@@ -36,6 +37,7 @@ extern bool PRINT_INITIALIZATION_DEBUG_INFORMATION;
 extern bool PRINT_GAME_SIMULATION_DEBUG_INFORMATION;
 
 extern int GAMES_PER_NETWORK_SAVE;
+extern std::string GAME_RECORD_FILE_PATH; // finished games are appended here (for OpeningBookBuilder) -> "" = off
 extern std::function<bool()> TRAINING_TERMINATION_CONDITION;
 
 extern std::function<void(std::vector<std::pair<game::Board *, double>> &, game::Board *, double)>
@@ -50,8 +52,25 @@ void initializeRNG(const std::string &rng_seed = "");
 void updateWorkingDirectory(const std::string &target_dir = "Chess-AI");
 void
 updateMCTSParameters(double thread_usage_ratio = 1.0, int simulation_move_depth = 8, int simulations_per_thread = 125);
+void updateMinimaxParameters(int transposition_table_size_in_mb = 32, double clock_in_seconds = 600.0,
+                             double increment_in_seconds = 5.0, int alpha_beta_threads = 1,
+                             bool print_search_information = false);
+void updateSelectiveSearchParameters(bool null_move_pruning = true, bool late_move_reductions = true,
+                                     bool futility_pruning = true);
+void updateSearchLimitParameters(long max_nodes = 0, int max_depth = 0, double movetime_in_seconds = 0.0,
+                                 double clock_in_seconds = 0.0, double increment_in_seconds = 0.0);
+void updatePonderingParameters(bool alpha_beta_pondering = true, bool mcts_pondering = true);
+void updateDeterministicSearchParameters(bool alpha_beta_deterministic = false, bool mcts_deterministic = false,
+                                         unsigned long mcts_seed = 0);
+void updateMateSearchParameters(long mcts_mate_search_nodes = 0, int mcts_mate_search_moves = 3,
+                                int table_size_in_mb = 16);
+void updateTablebaseParameters(const std::string &tablebase_directory = "tablebases");
+void updateOpeningBookParameters(const std::string &book_file_path = "assets/opening_book.bin",
+                                 player::OpeningBook::Policy policy = player::OpeningBook::WEIGHTED_RANDOM,
+                                 const std::string &game_record_file_path = "");
 void updateNetworkSettings(bool load_prev_network = true, bool save_networks = true,
                            const std::string &network_file_path = network::NetworkStorage::LATEST_NETWORK_FILE_PATH);
+void updateNetworkSearchParameters(int alpha_beta_batch_size = 4);
 void updateTrainingParameters(const std::function<bool()> &termination_condition = [] { return true; },
                               int network_save_interval_in_games = 20, double ratio_of_training_boards_to_save = 1.0);
 
@@ -27,6 +27,7 @@
 #include "initialization.h"
 
 #include "../graphics/opengl.h"
+#include "../player/opening_book.h"
 #include "../util/thread_util.h"
 
 game::GameResult game::run_game(player::PlayerType white, player::PlayerType black, bool run_graphics,
@@ -51,6 +52,8 @@ game::GameResult game::run_game(player::PlayerType white, player::PlayerType bla
     thread::wait_for([&] { return game->isOver(); });
   }
   game::GameResult result = game->getResult();
+  if (!settings::GAME_RECORD_FILE_PATH.empty())
+    player::OpeningBookBuilder::appendGameRecord(settings::GAME_RECORD_FILE_PATH, game->board(), result);
 
   // tell game to terminate
   game->endGame();
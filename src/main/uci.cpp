@@ -0,0 +1,331 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "uci.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../chess/piece.h"
+#include "../chess/game.h"
+#include "../mcts_network/tree.h"
+#include "../player/player.h"
+#include "../player/search.h"
+#include "../player/time_manager.h"
+#include "../player/transposition_table.h"
+#include "../util/thread_util.h"
+
+const char *uci::Session::ENGINE_NAME = "Chess-AI";
+const char *uci::Session::ENGINE_AUTHOR = "Utkarsh Priyam";
+const char *uci::Session::START_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Session class
+uci::Session::Session(std::ostream &output) : _output(output) {
+  // the gui decides when to think -> no searches on the opponent's time
+  player::AlphaBetaPlayer::PONDERING = false;
+  player::MonteCarloPlayer::PONDERING = false;
+  player::AlphaBetaPlayer::PRINT_SEARCH_INFORMATION = false;
+  player::MinimaxPlayer::ON_ITERATION = [this](const player::SearchStatistics &statistics,
+                                               const std::vector<player::SearchLine> &lines) {
+    sendInfo(statistics, lines);
+  };
+
+  _game = new game::Game(8, 8);
+  _position_fen = START_POSITION;
+  loadPosition();
+
+  _player_type = player::PlayerType::AB_PRUNING;
+  _are_players_outdated = true;
+  _is_searching = false;
+  _searching_player = nullptr;
+  _default_moves_to_go = player::TimeManager::MOVES_TO_GO;
+}
+
+uci::Session::~Session() {
+  stop();
+  player::MinimaxPlayer::ON_ITERATION = nullptr;
+  player::TimeManager::MOVES_TO_GO = _default_moves_to_go;
+  delete _game;
+}
+
+bool uci::Session::execute(const std::string &command) {
+  std::istringstream input(command);
+  std::string token;
+  if (!(input >> token))
+    return true;
+
+  if (token == "uci") {
+    identify();
+  } else if (token == "isready") {
+    if (!_is_searching)
+      updatePlayers(); // the expensive part of a new game (ie tables) happens before the clock runs
+    send("readyok");
+  } else if (token == "setoption") {
+    setOption(input);
+  } else if (token == "ucinewgame") {
+    newGame();
+  } else if (token == "position") {
+    setPosition(input);
+  } else if (token == "go") {
+    go(input);
+  } else if (token == "stop") {
+    stop();
+  } else if (token == "quit") {
+    stop();
+    return false;
+  } else if (token != "debug" && token != "ponderhit") {
+    send("info string unknown command " + token);
+  }
+  return true;
+}
+
+void uci::Session::send(const std::string &line) {
+  std::lock_guard<std::mutex> lock(_output_mutex);
+  _output << line << std::endl; // flushed -> the gui reads line by line
+}
+
+void uci::Session::sendInfo(const player::SearchStatistics &statistics,
+                            const std::vector<player::SearchLine> &lines) {
+  long time = (long) (1000 * statistics.elapsed);
+  for (std::size_t k = 0; k < lines.size(); ++k) {
+    std::ostringstream info;
+    info << "info depth " << lines[k].depth << " seldepth " << std::max(statistics.selective_depth, lines[k].depth);
+    if (lines.size() > 1)
+      info << " multipv " << k + 1;
+    info << " score " << scoreToString(lines[k].score) << " nodes " << statistics.nodes << " nps "
+         << (long) statistics.nps() << " time " << time << " pv";
+    for (const game::Move &move : lines[k].moves)
+      info << " " << move.toLongAlgebraic();
+    send(info.str());
+  }
+}
+
+void uci::Session::identify() {
+  send(std::string("id name ") + ENGINE_NAME);
+  send(std::string("id author ") + ENGINE_AUTHOR);
+  send("option name Player type combo default AlphaBeta var AlphaBeta var Minimax var MCTS var Network var "
+       "NetworkAlphaBeta var Random");
+  send("option name Threads type spin default " + std::to_string(player::AlphaBetaPlayer::DEFAULT_NUM_THREADS) +
+       " min 1 max 256");
+  send("option name Hash type spin default " + std::to_string(player::TranspositionTable::DEFAULT_SIZE_IN_MB) +
+       " min 1 max 65536");
+  send("uciok");
+}
+
+void uci::Session::setOption(std::istringstream &input) {
+  // setoption name <name (may have spaces)> [value <value>]
+  std::string token, name, value;
+  input >> token; // "name"
+  while (input >> token && token != "value")
+    name += (name.empty() ? "": " ") + token;
+  std::getline(input >> std::ws, value);
+
+  if (name == "Player") {
+    if (value == "AlphaBeta")
+      _player_type = player::PlayerType::AB_PRUNING;
+    else if (value == "Minimax")
+      _player_type = player::PlayerType::MINIMAX;
+    else if (value == "MCTS")
+      _player_type = player::PlayerType::MCTS;
+    else if (value == "Network")
+      _player_type = player::PlayerType::AI;
+    else if (value == "NetworkAlphaBeta")
+      _player_type = player::PlayerType::AI_AB_PRUNING;
+    else if (value == "Random")
+      _player_type = player::PlayerType::RANDOM;
+    else {
+      send("info string unknown player " + value);
+      return;
+    }
+  } else if (name == "Threads") {
+    int threads = std::max(std::atoi(value.c_str()), 1);
+    player::AlphaBetaPlayer::DEFAULT_NUM_THREADS = threads;
+    tree::MCTS::DEFAULT_NUM_THREADS = threads;
+  } else if (name == "Hash") {
+    player::TranspositionTable::DEFAULT_SIZE_IN_MB = std::max(std::atoi(value.c_str()), 1);
+  } else {
+    send("info string unknown option " + name);
+    return;
+  }
+  _are_players_outdated = true;
+}
+
+void uci::Session::newGame() {
+  stop();
+  _are_players_outdated = true; // fresh players -> nothing carried over from the last game (tables, trees)
+  _position_fen = START_POSITION;
+  _position_moves.clear();
+  loadPosition();
+}
+
+void uci::Session::setPosition(std::istringstream &input) {
+  // position [startpos | fen <6 fields>] [moves <move>...]
+  stop();
+  std::string token, fen;
+  input >> token;
+  if (token == "fen") {
+    while (input >> token && token != "moves")
+      fen += (fen.empty() ? "": " ") + token;
+  } else {
+    fen = START_POSITION;
+    input >> token; // "moves" (if any)
+  }
+
+  _position_fen = fen;
+  _position_moves.clear();
+  while (input >> token)
+    _position_moves.push_back(token);
+  loadPosition();
+}
+
+void uci::Session::loadPosition() {
+  if (!_game->loadFromFEN(_position_fen)) {
+    send("info string invalid fen " + _position_fen);
+    _position_fen = START_POSITION;
+    _position_moves.clear();
+    _game->loadFromFEN(_position_fen);
+  }
+
+  for (std::size_t i = 0; i < _position_moves.size(); ++i) {
+    game::Move move = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+    if (!_game->findMove(_position_moves[i], &move)) {
+      send("info string illegal move " + _position_moves[i]);
+      _position_moves.resize(i);
+      break;
+    }
+    _game->applyMove(move);
+  }
+}
+
+void uci::Session::go(std::istringstream &input) {
+  stop();
+
+  // times are in ms -> SearchLimits are in seconds
+  player::SearchLimits limits;
+  double time[2] = {0.0, 0.0}, increment[2] = {0.0, 0.0};
+  int moves_to_go = 0;
+  std::string token;
+  while (input >> token) {
+    if (token == "wtime")
+      input >> time[piece::PieceColor::WHITE];
+    else if (token == "btime")
+      input >> time[piece::PieceColor::BLACK];
+    else if (token == "winc")
+      input >> increment[piece::PieceColor::WHITE];
+    else if (token == "binc")
+      input >> increment[piece::PieceColor::BLACK];
+    else if (token == "movestogo")
+      input >> moves_to_go;
+    else if (token == "depth")
+      input >> limits.depth;
+    else if (token == "nodes")
+      input >> limits.nodes;
+    else if (token == "movetime")
+      input >> limits.movetime;
+    else if (token == "infinite")
+      limits.infinite = true;
+  }
+
+  piece::PieceColor color = _game->getCurrentColor();
+  limits.clock = std::max(time[color], 0.0) / 1000.0;
+  limits.increment = std::max(increment[color], 0.0) / 1000.0;
+  limits.movetime = std::max(limits.movetime, 0.0) / 1000.0;
+  player::TimeManager::MOVES_TO_GO = moves_to_go > 0 ? moves_to_go: _default_moves_to_go;
+
+  if (_game->possibleMoves(color).empty()) { // mated or stalemated -> nothing to search
+    send("bestmove 0000");
+    return;
+  }
+
+  updatePlayers();
+  player::Player *player = color.isWhite() ? _game->white_player(): _game->black_player();
+  player->setSearchLimits(limits);
+
+  _searching_player = player;
+  _is_searching = true;
+  thread::create(search, this, player);
+}
+
+void uci::Session::stop() {
+  // the player may not have started its clock yet -> stopped until the search is over, not just once
+  thread::do_while_waiting_for([&] {
+    player::Player *player = _searching_player;
+    if (player != nullptr)
+      player->stop();
+  }, [&] { return !_is_searching; });
+}
+
+void uci::Session::updatePlayers() {
+  if (!_are_players_outdated)
+    return;
+
+  _game->setPlayer(piece::PieceColor::WHITE, _player_type);
+  _game->setPlayer(piece::PieceColor::BLACK, _player_type);
+  _are_players_outdated = false;
+}
+
+void uci::Session::search(Session *session, player::Player *player) {
+  game::Board *board = session->_game->board();
+  int move_count = board->move_count();
+  auto start = std::chrono::steady_clock::now();
+  player->playNextMove();
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::string best_move = "0000";
+  if (board->move_count() != move_count)
+    best_move = board->moveHistory().back().toLongAlgebraic();
+
+  // minimax players already sent their iterations -> everyone else only gets a summary
+  if (!player->type().isMinimaxPlayer() && !player->type().isAlphaBetaPruningPlayer() &&
+      !player->type().isAIAlphaBetaPruningPlayer())
+    session->send("info time " + std::to_string((long) (1000 * elapsed)));
+
+  session->loadPosition(); // the move was played on the game -> back to the position the gui set
+  session->send("bestmove " + best_move);
+  session->_searching_player = nullptr;
+  session->_is_searching = false;
+}
+
+std::string uci::Session::scoreToString(int score) {
+  // mates && tablebase wins are (MATE_SCORE or TABLEBASE_WIN_SCORE) - plies to mate -> the distance is in the score
+  int plies;
+  if (std::abs(score) >= player::SearchEngine::MATE_BOUND)
+    plies = player::SearchEngine::MATE_SCORE - std::abs(score);
+  else if (std::abs(score) >= player::SearchEngine::TABLEBASE_BOUND)
+    plies = player::SearchEngine::TABLEBASE_WIN_SCORE - std::abs(score);
+  else
+    return "cp " + std::to_string(100 * score);
+
+  int moves = (plies + 1) / 2; // mated -> plies is even
+  return "mate " + std::to_string(score > 0 ? moves: -moves);
+}
+
+void uci::run(std::istream &input, std::ostream &output) {
+  Session session(output);
+  std::string line;
+  while (std::getline(input, line))
+    if (!session.execute(line))
+      break;
+}
@@ -0,0 +1,99 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_MAIN_UCI_H_
+#define CHESS_AI_MAIN_UCI_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+
+#include "../chess/game.fwd.h"
+#include "../player/player.fwd.h"
+#include "../player/search.fwd.h"
+
+namespace uci {
+
+// The Session class: one engine as seen by a UCI gui (or tournament manager), w/o any graphics
+// The moves are found by the regular players (alpha-beta, mcts, network...) of a game that only exists to hold the
+// position -> each "go" is the current player's playNextMove(), run on its own thread so "stop" can still be read
+// Everything written to output is protocol -> no other part of the program may print to it while a session runs
+class Session {
+  public:
+    Session() = delete;
+    Session(const Session &s) = delete;
+    Session &operator=(const Session &s) = delete;
+
+    explicit Session(std::ostream &output);
+    ~Session();
+
+    bool execute(const std::string &command); // one line of input -> false once the session is over ("quit")
+
+    static const char *ENGINE_NAME;
+    static const char *ENGINE_AUTHOR;
+    static const char *START_POSITION; // fen
+
+  private:
+    std::ostream &_output;
+    std::mutex _output_mutex; // info lines come from the search thread, everything else from the input thread
+
+    game::Game *_game;
+    player::PlayerType _player_type;
+    bool _are_players_outdated; // options changed -> new players before the next search
+
+    // last "position" command -> the position is set up again after every search (the player plays its move on it)
+    std::string _position_fen;
+    std::vector<std::string> _position_moves;
+
+    std::atomic_bool _is_searching;
+    std::atomic<player::Player *> _searching_player;
+    int _default_moves_to_go;
+
+    void send(const std::string &line);
+    void sendInfo(const player::SearchStatistics &statistics, const std::vector<player::SearchLine> &lines);
+
+    void identify();
+    void setOption(std::istringstream &input);
+    void newGame();
+    void setPosition(std::istringstream &input);
+    void loadPosition(); // _position_fen + _position_moves -> illegal moves && the ones after them are dropped
+    void go(std::istringstream &input);
+    void stop(); // waits for the best move to be sent
+
+    void updatePlayers();
+    static void search(Session *session, player::Player *player);
+
+    // "cp x" (evaluator units are pawns) or "mate n" (n < 0 -> getting mated) for mate && tablebase scores
+    static std::string scoreToString(int score);
+};
+
+// reads commands from input until "quit" (or the end of input) -> see Session
+void run(std::istream &input, std::ostream &output);
+
+}
+
+#endif // CHESS_AI_MAIN_UCI_H_
@@ -41,13 +41,10 @@ std::pair<double, std::map<game::Move, double>> decider::Decider::prediction(gam
   std::vector<game::Move> temp_vec;
 
   for (auto &move : moves)
-    if (move.verify(board)) {
-      board->doMove(new game::Move(move), game);
+    if (game->isLegalMove(move)) {
+      board->doMove(move, game);
 
-      if (current_color.isWhite())
-        board->getPossibleMoves(nullptr, &temp_vec);
-      else
-        board->getPossibleMoves(&temp_vec, nullptr);
+      board->getCachedMoves(!current_color, &temp_vec);
 
       if (temp_vec.empty())
         actionMap[move] = color_multiplier * predictPosition(board);
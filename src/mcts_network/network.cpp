@@ -116,10 +116,97 @@ double network::Network::predictPosition(game::Board *b) {
   return compact_network[_output_index % 2][0];
 }
 
+// sums[r][k] = inputs[r] . column j + k of weights, for ROWS positions && COLUMNS neurons at once
+// every weight loaded is used for all the positions && the sums stay in registers -> fixed sizes (&& unrolled), so
+// the loops vectorize
+template<int ROWS, int COLUMNS>
+static void multiplyBlock(const double *inputs, int width, const std::vector<std::vector<double>> &weights, int j,
+                          double sums[][COLUMNS]) {
+  double block[ROWS][COLUMNS] = {}; // local -> can't alias inputs or weights, so it stays in registers
+  for (int i = 0; i < width; ++i) {
+    const double *w = weights[i].data() + j;
+#pragma GCC unroll 4
+    for (int r = 0; r < ROWS; ++r)
+#pragma GCC unroll 4
+      for (int k = 0; k < COLUMNS; ++k)
+        block[r][k] += inputs[r * width + i] * w[k];
+  }
+
+  for (int r = 0; r < ROWS; ++r)
+    for (int k = 0; k < COLUMNS; ++k)
+      sums[r][k] = block[r][k];
+}
+
+// one layer for ROWS positions -> outputs[r * next_width + j] = f(inputs[r] . column j of weights)
+template<int ROWS>
+static void propagateRows(const double *inputs, int width, const std::vector<std::vector<double>> &weights,
+                          int next_width, double *outputs, double (*threshold)(double)) {
+  const int COLUMNS = 4;
+  double sums[ROWS][COLUMNS];
+  for (int j = 0; j < next_width; j += COLUMNS) {
+    int columns = std::min(COLUMNS, next_width - j);
+    if (columns == COLUMNS) {
+      multiplyBlock<ROWS, COLUMNS>(inputs, width, weights, j, sums);
+    } else { // last few neurons of the layer (ie the output neuron)
+      double tail[ROWS][1];
+      for (int k = 0; k < columns; ++k) {
+        multiplyBlock<ROWS, 1>(inputs, width, weights, j + k, tail);
+        for (int r = 0; r < ROWS; ++r)
+          sums[r][k] = tail[r][0];
+      }
+    }
+
+    for (int r = 0; r < ROWS; ++r)
+      for (int k = 0; k < columns; ++k)
+        outputs[r * next_width + j + k] = threshold(sums[r][k]);
+  }
+}
+
+void network::Network::predictPositions(const std::vector<double> &inputs, int count, std::vector<double> *outputs,
+                                        std::vector<double> *scratch) {
+  // 2 layers of count rows each -> the one being read && the one being written
+  scratch->resize(2 * count * _max_width);
+  double *current = scratch->data(), *next = current + count * _max_width;
+
+  // positions are INPUT_SIZE apart in inputs (see encodeBoard(...)) -> copied row by row, so a network w/ another
+  // input width still reads each position from its own row (cut off or zero padded)
+  int input_width = _dimensions[0];
+  if (input_width != INPUT_SIZE || (int) inputs.size() < count * INPUT_SIZE) {
+    DEBUG_ASSERT
+    std::fill(current, current + count * input_width, 0.0);
+  }
+  int copied = std::min(input_width, INPUT_SIZE);
+  for (int b = 0; b < count && (b + 1) * INPUT_SIZE <= (int) inputs.size(); ++b)
+    std::copy(inputs.begin() + b * INPUT_SIZE, inputs.begin() + b * INPUT_SIZE + copied, current + b * input_width);
+
+  // same sums in the same order as predictPosition(...) -> same outputs, just BATCH_BLOCK positions per weight read
+  int n, b, prev;
+  for (n = 1; n < _num_layers; ++n) {
+    prev = n - 1;
+    int width = _dimensions[prev], next_width = _dimensions[n];
+
+    for (b = 0; b + BATCH_BLOCK <= count; b += BATCH_BLOCK)
+      propagateRows<BATCH_BLOCK>(current + b * width, width, _connections[prev], next_width, next + b * next_width, f);
+    for (; b < count; ++b)
+      propagateRows<1>(current + b * width, width, _connections[prev], next_width, next + b * next_width, f);
+    std::swap(current, next);
+  }
+
+  outputs->resize(count);
+  for (b = 0; b < count; ++b)
+    (*outputs)[b] = current[b]; // 1 output neuron
+}
+
+void network::Network::encodeBoard(game::Board *b, double *input) {
+  // empty squares are 0 -> only occupied squares need to be written
+  std::fill(input, input + INPUT_SIZE, 0.0);
+  b->forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+    input[r * b->width() + c] = piece->code(); // get values of pieces from board
+  });
+}
+
 void network::Network::loadBoard(game::Board *b, std::vector<double> &input) {
-  std::vector<piece::Piece *> board = b->pieces();
-  for (int i = 0; i < _dimensions[0]; i++)
-    input[i] = board[i]->code(); // get values of pieces from board
+  encodeBoard(b, input.data());
 }
 
 void network::Network::propagate_for_training() {
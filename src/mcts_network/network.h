@@ -70,6 +70,17 @@ class Network : public decider::Decider {
 
     static Network *loadFromFile(const std::string &file_path);
 
+    // forward pass of count positions at once -> inputs holds count * INPUT_SIZE values (see encodeBoard(...)), one
+    // output per position (white's view, like predictPosition(...)); each layer is one matrix-matrix product, so every
+    // weight is read once per batch instead of once per position
+    // only reads the network -> safe to call from several threads, each w/ its own scratch
+    void predictPositions(const std::vector<double> &inputs, int count, std::vector<double> *outputs,
+                          std::vector<double> *scratch);
+    static void encodeBoard(game::Board *b, double *input); // INPUT_SIZE values, one per square
+
+    static const int INPUT_SIZE = 64;
+    static const int BATCH_BLOCK = 4; // positions per weight read in predictPositions(...)
+
   protected:
     double predictPosition(game::Board *b) override;
 
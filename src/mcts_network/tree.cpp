@@ -35,9 +35,13 @@
 #include <atomic>
 #include <iostream>
 #include <climits>
+#include <algorithm>
 
 #include "../chess/game.h"
 #include "decider.h"
+#include "../player/search.h"
+#include "../player/time_manager.h"
+#include "../player/tablebase.h"
 #include "../util/thread_util.h"
 
 // Node class
@@ -119,6 +123,16 @@ std::pair<game::Move, tree::Node *> tree::Node::selectOptimalMove(const std::fun
   return optimal;
 }
 
+tree::Node *tree::Node::detachChild(const game::Move &move) {
+  auto it = _children.find(move);
+  if (it == _children.end())
+    return nullptr;
+
+  Node *child = it->second;
+  _children.erase(it);
+  return child;
+}
+
 tree::Node *tree::Node::combineNodes(const std::vector<Node *> &nodes, int num_nodes) {
   piece::PieceColor root_color = nodes[0]->color_to_play();
   auto *new_node = new Node(root_color);
@@ -145,18 +159,23 @@ tree::Node *tree::Node::combineNodes(const std::vector<Node *> &nodes, int num_n
 int tree::MCTS::SIMULATION_SEARCH_DEPTH = 8;
 int tree::MCTS::NUM_SIMULATIONS_PER_THREAD = 125;
 int tree::MCTS::DEFAULT_NUM_THREADS = 4;
+bool tree::MCTS::DETERMINISTIC = false;
+unsigned long tree::MCTS::SEED = 0;
 
 std::pair<game::Move, tree::Node *>
-tree::MCTS::run_mcts_multithreaded(game::Game *game, decider::Decider *move_ranker) {
-  return run_mcts_multithreaded(game, DEFAULT_NUM_THREADS, move_ranker);
+tree::MCTS::run_mcts_multithreaded(game::Game *game, decider::Decider *move_ranker, const player::SearchLimits *limits,
+                                   const player::TimeManager *time_manager) {
+  return run_mcts_multithreaded(game, DEFAULT_NUM_THREADS, move_ranker, limits, time_manager);
 }
 std::pair<game::Move, tree::Node *>
-tree::MCTS::run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker) {
+tree::MCTS::run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker,
+                                   const player::SearchLimits *limits, const player::TimeManager *time_manager) {
   std::vector<Node *> roots(num_threads);
   for (int i = 0; i < num_threads; ++i)
     roots[i] = new Node(game->getCurrentColor());
 
-  std::pair<game::Move, tree::Node *> return_val = run_mcts_multithreaded(game, num_threads, move_ranker, roots);
+  std::pair<game::Move, tree::Node *> return_val = run_mcts_multithreaded(game, num_threads, move_ranker, roots,
+                                                                          limits, time_manager);
 
   for (auto &it: roots)
     delete it;
@@ -166,26 +185,42 @@ tree::MCTS::run_mcts_multithreaded(game::Game *game, int num_threads, decider::D
 }
 std::pair<game::Move, tree::Node *>
 tree::MCTS::run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker,
-                                   const std::vector<Node *> &roots) {
+                                   const std::vector<Node *> &roots, const player::SearchLimits *limits,
+                                   const player::TimeManager *time_manager, const std::atomic_bool *abort) {
   if (roots.size() < num_threads) {
     DEBUG_ASSERT
     num_threads = roots.size();
   }
 
-  std::atomic_int iteration_counter{NUM_SIMULATIONS_PER_THREAD * num_threads};
+  // NUM_SIMULATIONS_PER_THREAD is only the default -> a search w/ a time control runs until time (or abort)
+  int simulations = NUM_SIMULATIONS_PER_THREAD * num_threads;
+  if (limits != nullptr && limits->nodes > 0)
+    simulations = (int) std::min(limits->nodes, (long) INT_MAX);
+  else if (limits != nullptr && limits->hasTimeControl() && !DETERMINISTIC)
+    simulations = INT_MAX;
+
+  // threads take simulations from a shared counter until it runs out -> fast threads run more of them
+  // deterministic -> thread i runs its own share instead
+  std::atomic_int iteration_counter{simulations};
   std::atomic_int thread_counter{0};
+  auto *thread_iteration_counters = new std::atomic_int[num_threads];
 
   std::vector<game::Game *> clones(num_threads);
   for (int i = 0; i < num_threads; ++i) {
     clones[i] = game->clone();
+    thread_iteration_counters[i] = simulations / num_threads + (i < simulations % num_threads);
 
     expand_node(roots[i], clones[i], move_ranker);
-    add_dirichlet_noise(roots[i]);
+    add_dirichlet_noise(roots[i], DETERMINISTIC ? SEED + game->board()->hash() + i:
+                                  (unsigned long) ((double) LONG_MAX * math::random()));
 
-    thread::create(mcts, clones[i], move_ranker, roots[i], std::ref(iteration_counter), std::ref(thread_counter));
+    thread::create(mcts, clones[i], move_ranker, roots[i],
+                   std::ref(DETERMINISTIC ? thread_iteration_counters[i]: iteration_counter),
+                   std::ref(thread_counter), DETERMINISTIC ? nullptr: time_manager, abort);
   }
 
   thread::wait_for([&] { return thread_counter >= num_threads; });
+  delete[] thread_iteration_counters;
 
   for (auto &clone: clones)
     delete clone;
@@ -200,15 +235,21 @@ std::pair<game::Move, tree::Node *> tree::MCTS::run_mcts(game::Game *game, decid
 }
 
 void tree::MCTS::mcts(game::Game *game, decider::Decider *move_ranker, Node *root,
-                      std::atomic_int &search_iteration_count, std::atomic_int &thread_finished_count) {
+                      std::atomic_int &search_iteration_count, std::atomic_int &thread_finished_count,
+                      const player::TimeManager *time_manager, const std::atomic_bool *abort) {
   Node *node;
   game::Game *clone;
   std::vector<Node *> searchPath;
+  const player::Tablebases *tables = player::Tablebases::LOADED;
+  player::Tablebases::Result tablebase_result{};
+  bool is_tablebase_hit;
 
-  while (search_iteration_count-- > 0) {
+  while (search_iteration_count-- > 0 && (abort == nullptr || !*abort) &&
+         (time_manager == nullptr || !time_manager->optimumReached())) {
     node = root;
     clone = game->clone();
     searchPath = {root};
+    is_tablebase_hit = false;
 
     for (int i = 0; i < SIMULATION_SEARCH_DEPTH; ++i) {
       if (clone->isOver())
@@ -218,14 +259,16 @@ void tree::MCTS::mcts(game::Game *game, decider::Decider *move_ranker, Node *roo
 
       std::pair<game::Move, Node *> optimal = select_optimal_move(node);
       node = optimal.second;
-      bool success = clone->tryMove(optimal.first);
-      if (!success) {
-        DEBUG_ASSERT
-        delete clone;
-        goto TERMINATE_LOOP; // jump to end of mcts
-      }
+      clone->applyMove(optimal.first); // children come from the legal move list -> no need to re-verify
 
       searchPath.push_back(node);
+
+      // the endgame tables know how this ends -> no need to look further
+      if (tables != nullptr && !clone->isOver() &&
+          tables->probe(clone->board(), clone->getCurrentColor(), &tablebase_result)) {
+        is_tablebase_hit = true;
+        break;
+      }
     }
 
     double curr_color_code = clone->getCurrentColor().value();
@@ -241,6 +284,10 @@ void tree::MCTS::mcts(game::Game *game, decider::Decider *move_ranker, Node *roo
       // If game is drawn:
       // value is ((±1 * 0) + 1) / 2 = 0.5, which is correct b/c it is a draw
       value = (curr_color_code * clone->getResult().evaluate() + 1.0) / 2.0;
+    } else if (is_tablebase_hit) {
+      // same scale as above -> 0 if the current color loses, 1 if it wins
+      value = tablebase_result.outcome == player::Tablebases::WIN ? 1.0:
+              tablebase_result.outcome == player::Tablebases::LOSS ? 0.0: 0.5;
     } else { // game is not over
       // unknown outcome... using minimax board scoring -> TODO find better default result - finished??
       value = clone->board()->score(
@@ -257,7 +304,6 @@ void tree::MCTS::mcts(game::Game *game, decider::Decider *move_ranker, Node *roo
     delete clone;
   }
 
-  TERMINATE_LOOP:
   thread_finished_count++;
 }
 
@@ -315,10 +361,10 @@ double tree::MCTS::expand_node(tree::Node *node, game::Game *game, decider::Deci
   return 0.5;
 }
 
-void tree::MCTS::add_dirichlet_noise(Node *node) {
+void tree::MCTS::add_dirichlet_noise(Node *node, unsigned long seed) {
   // set up rng
   gsl_rng *rng = gsl_rng_alloc(gsl_rng_mt19937);
-  gsl_rng_set(rng, (long) ((double) LONG_MAX * math::random()));
+  gsl_rng_set(rng, seed);
 
   // Straight from Google/DeepMind's AlphaZero paper
   const double DIRICHLET_NOISE_ALPHA_VALUE = 0.2;
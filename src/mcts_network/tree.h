@@ -40,6 +40,8 @@
 #include "../chess/piece.h"
 #include "../chess/game.fwd.h"
 #include "decider.fwd.h"
+#include "../player/search.fwd.h"
+#include "../player/time_manager.fwd.h"
 
 namespace tree {
 
@@ -69,6 +71,7 @@ class Node {
     void addNoise(double frac, const double *noise);
 
     std::pair<game::Move, tree::Node *> selectOptimalMove(const std::function<double(Node *, Node *)> &ranker);
+    Node *detachChild(const game::Move &move); // removes the subtree from this node -> caller owns it (or nullptr)
 
     static Node *combineNodes(const std::vector<Node *> &nodes, int num_nodes);
 
@@ -91,12 +94,18 @@ class MCTS {
     MCTS(const MCTS &mcts) = delete;
     MCTS &operator=(const MCTS &mcts) = delete;
 
-    static std::pair<game::Move, Node *> run_mcts_multithreaded(game::Game *game, decider::Decider *move_ranker);
+    // limits -> simulations && time (w/ time_manager, already started) -> nullptr = NUM_SIMULATIONS_PER_THREAD each
     static std::pair<game::Move, Node *>
-    run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker);
+    run_mcts_multithreaded(game::Game *game, decider::Decider *move_ranker, const player::SearchLimits *limits = nullptr,
+                           const player::TimeManager *time_manager = nullptr);
     static std::pair<game::Move, Node *>
     run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker,
-                           const std::vector<Node *> &roots);
+                           const player::SearchLimits *limits = nullptr,
+                           const player::TimeManager *time_manager = nullptr);
+    static std::pair<game::Move, Node *>
+    run_mcts_multithreaded(game::Game *game, int num_threads, decider::Decider *move_ranker,
+                           const std::vector<Node *> &roots, const player::SearchLimits *limits = nullptr,
+                           const player::TimeManager *time_manager = nullptr, const std::atomic_bool *abort = nullptr);
 
     static std::pair<game::Move, Node *> run_mcts(game::Game *game, decider::Decider *move_ranker);
 
@@ -104,15 +113,22 @@ class MCTS {
     static int NUM_SIMULATIONS_PER_THREAD;
     static int DEFAULT_NUM_THREADS;
 
+    // same position && limits -> same trees (&& move), whatever the thread timing
+    // each thread runs a fixed share of the simulations && seeds its root noise from SEED, the position && its
+    // index -> the clock is ignored, only the simulation count (or an abort) stops the search
+    static bool DETERMINISTIC;
+    static unsigned long SEED;
+
   private:
     static void mcts(game::Game *game, decider::Decider *move_ranker, Node *root,
-                     std::atomic_int &search_iteration_count, std::atomic_int &thread_finished_count);
+                     std::atomic_int &search_iteration_count, std::atomic_int &thread_finished_count,
+                     const player::TimeManager *time_manager, const std::atomic_bool *abort);
 
     static double expand_node(Node *node, game::Game *game, decider::Decider *move_ranker);
     static std::pair<game::Move, Node *> select_optimal_move(Node *parent);
     static double score_move(Node *parent, Node *child);
     static void propagate_result(std::vector<Node *> &searchPath, double value, piece::PieceColor color);
-    static void add_dirichlet_noise(Node *node);
+    static void add_dirichlet_noise(Node *node, unsigned long seed);
 };
 
 }
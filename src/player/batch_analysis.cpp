@@ -0,0 +1,367 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "batch_analysis.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cctype>
+
+#include "../chess/piece.h"
+#include "../util/thread_util.h"
+#include "../util/assert_util.h"
+#include "time_manager.h"
+
+const char player::PositionFile::MAGIC[8] = {'C', 'A', 'I', 'P', 'O', 'S', '0', '1'};
+
+// PositionFile class
+bool player::PositionFile::read(const std::string &file_path, std::vector<std::string> *fens) {
+  std::ifstream in_stream(file_path, std::ios::binary);
+  if (!in_stream.is_open())
+    return false;
+
+  Header header{};
+  in_stream.read((char *) &header, sizeof(header));
+  if (in_stream && std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0) {
+    Record record{};
+    for (uint64_t i = 0; i < header.position_count; ++i) {
+      if (!in_stream.read((char *) &record, sizeof(record))) {
+        DEBUG_ASSERT // -> truncated file
+        return false;
+      }
+      fens->push_back(unpack(record));
+    }
+    return true;
+  }
+
+  // text -> one fen per line, blank lines && lines starting w/ '#' are skipped
+  in_stream.clear();
+  in_stream.seekg(0);
+  std::string line;
+  while (std::getline(in_stream, line)) {
+    std::size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+    std::size_t last = line.find_last_not_of(" \t\r");
+    fens->push_back(line.substr(first, last - first + 1));
+  }
+  return true;
+}
+
+long player::PositionFile::write(const std::string &file_path, const std::vector<std::string> &fens) {
+  std::vector<Record> records;
+  records.reserve(fens.size());
+  Record record{};
+  for (const std::string &fen : fens)
+    if (pack(fen, &record))
+      records.push_back(record);
+
+  std::ofstream out_stream(file_path, std::ios::binary | std::ios::trunc);
+  if (!out_stream.is_open()) {
+    DEBUG_ASSERT
+    return -1;
+  }
+
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.position_count = records.size();
+
+  out_stream.write((const char *) &header, sizeof(header));
+  out_stream.write((const char *) records.data(), (std::streamsize) (records.size() * sizeof(Record)));
+  if (!out_stream) {
+    DEBUG_ASSERT
+    return -1;
+  }
+  return (long) records.size();
+}
+
+bool player::PositionFile::pack(const std::string &fen, Record *record) {
+  std::istringstream input(fen);
+  std::string placement, side, castling = "-", en_passant = "-";
+  input >> placement >> side >> castling >> en_passant;
+  if (side != "w" && side != "b")
+    return false;
+
+  // letters in PieceType order (KING, QUEEN, ROOK, KNIGHT, BISHOP, PAWN) -> same as Board::loadFromFEN(...)
+  const std::string LETTERS = "kqrnbp";
+  std::memset(record, 0, sizeof(Record));
+  int r = 7, c = 0;
+  for (char ch : placement) {
+    if (ch == '/') {
+      if (c != 8 || r == 0)
+        return false;
+      --r;
+      c = 0;
+    } else if ('1' <= ch && ch <= '8') {
+      c += ch - '0';
+    } else {
+      std::size_t type = LETTERS.find((char) std::tolower(ch));
+      if (type == std::string::npos || c >= 8)
+        return false;
+      int square = r * 8 + c, code = (int) type + (std::isupper(ch) ? 1: 9);
+      record->squares[square / 2] |= (uint8_t) (code << (square % 2 * 4));
+      ++c;
+    }
+    if (c > 8)
+      return false;
+  }
+  if (r != 0 || c != 8)
+    return false;
+
+  record->flags = side == "b";
+  const std::string CASTLING = "KQkq";
+  for (std::size_t i = 0; i < CASTLING.size(); ++i)
+    if (castling.find(CASTLING[i]) != std::string::npos)
+      record->flags |= (uint8_t) (2 << i);
+
+  record->en_passant = NO_SQUARE;
+  if (en_passant != "-") {
+    if (en_passant.size() != 2 || en_passant[0] < 'a' || en_passant[0] > 'h' ||
+        (en_passant[1] != '3' && en_passant[1] != '6'))
+      return false;
+    record->en_passant = (uint8_t) ((en_passant[1] - '1') * 8 + (en_passant[0] - 'a'));
+  }
+  return true;
+}
+
+std::string player::PositionFile::unpack(const Record &record) {
+  const std::string LETTERS = "kqrnbp";
+  std::string fen;
+  for (int r = 7; r >= 0; --r) {
+    int empty = 0;
+    for (int c = 0; c < 8; ++c) {
+      int square = r * 8 + c, code = (record.squares[square / 2] >> (square % 2 * 4)) & 0xF;
+      if (code == 0) {
+        ++empty;
+        continue;
+      }
+      if (empty > 0)
+        fen += (char) ('0' + empty);
+      empty = 0;
+      char letter = LETTERS[(code - 1) % 8];
+      fen += code < 9 ? (char) std::toupper(letter): letter;
+    }
+    if (empty > 0)
+      fen += (char) ('0' + empty);
+    if (r > 0)
+      fen += '/';
+  }
+
+  fen += record.flags & 1 ? " b ": " w ";
+  const std::string CASTLING = "KQkq";
+  std::string castling;
+  for (std::size_t i = 0; i < CASTLING.size(); ++i)
+    if (record.flags & (2 << i))
+      castling += CASTLING[i];
+  fen += castling.empty() ? "-": castling;
+
+  fen += " ";
+  if (record.en_passant == NO_SQUARE)
+    fen += "-";
+  else {
+    fen += (char) ('a' + record.en_passant % 8);
+    fen += (char) ('1' + record.en_passant / 8);
+  }
+  return fen + " 0 1";
+}
+
+// BatchAnalyzer class
+player::BatchAnalyzer::BatchAnalyzer(const SearchConfig &config, const SearchLimits &limits, int num_threads) {
+  if (num_threads < 1) DEBUG_ASSERT
+  _limits = limits;
+  _fens = nullptr;
+  _on_result = nullptr;
+
+  // the parallelism is across positions -> every engine searches w/ a single thread, && quietly
+  SearchConfig worker_config = config;
+  worker_config.num_threads = 1;
+  worker_config.print_search_information = false;
+  for (int i = 0; i < std::max(num_threads, 1); ++i) {
+    auto *worker = new Worker();
+    worker->engine = new SearchEngine(worker_config);
+    worker->board = new game::Board(8, 8);
+    _workers.push_back(worker);
+  }
+}
+
+player::BatchAnalyzer::~BatchAnalyzer() {
+  for (Worker *worker : _workers) {
+    delete worker->engine;
+    delete worker->board;
+    delete worker;
+  }
+}
+
+void player::BatchAnalyzer::analyze(const std::vector<std::string> &fens,
+                                    const std::function<void(const Result &)> &on_result) {
+  _fens = &fens;
+  _on_result = &on_result;
+
+  // contiguous runs -> neighbouring positions (often from the same game) stay w/ the same engine && its tables
+  std::size_t num_workers = _workers.size();
+  for (std::size_t i = 0; i < num_workers; ++i) {
+    std::size_t first = fens.size() * i / num_workers, last = fens.size() * (i + 1) / num_workers;
+    std::lock_guard<std::mutex> lock(_workers[i]->mutex);
+    for (std::size_t index = first; index < last; ++index)
+      _workers[i]->queue.push_back(index);
+  }
+
+  std::atomic_int workers_finished{0};
+  for (std::size_t i = 1; i < num_workers; ++i)
+    thread::create(work, this, i, std::ref(workers_finished));
+  work(this, 0, workers_finished); // the calling thread is worker 0
+  thread::wait_for([&] { return workers_finished >= (int) num_workers; });
+
+  _fens = nullptr;
+  _on_result = nullptr;
+}
+
+long player::BatchAnalyzer::run(const std::string &positions_file_path, const std::string &output_file_path,
+                                bool print_progress) {
+  std::vector<std::string> fens;
+  if (!PositionFile::read(positions_file_path, &fens))
+    return -1;
+
+  std::ofstream out_stream(output_file_path, std::ios::trunc);
+  if (!out_stream.is_open()) {
+    DEBUG_ASSERT
+    return -1;
+  }
+
+  if (print_progress)
+    std::cout << "Analyzing " << fens.size() << " positions from \"" << positions_file_path << "\" w/ "
+              << _workers.size() << " threads..." << std::endl;
+  auto start = std::chrono::steady_clock::now();
+
+  long num_done = 0, num_invalid = 0, total_nodes = 0;
+  std::size_t progress_interval = std::max(fens.size() / 20, (std::size_t) 1);
+  analyze(fens, [&](const Result &result) {
+    // flushed per line -> finished positions survive an interrupted run
+    writeResult(out_stream, result);
+    out_stream.flush();
+
+    ++num_done;
+    num_invalid += !result.valid;
+    total_nodes += result.nodes;
+    if (print_progress && (num_done % progress_interval == 0 || num_done == (long) fens.size()))
+      std::cout << "  " << num_done << "/" << fens.size() << " positions analyzed" << std::endl;
+  });
+
+  if (print_progress) {
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Analyzed " << num_done << " positions (" << num_invalid << " invalid) in " << elapsed << "s -> "
+              << (elapsed > 0.0 ? num_done / elapsed: 0.0) << " positions/s, "
+              << (elapsed > 0.0 ? total_nodes / elapsed: 0.0) << " nps" << std::endl << std::endl;
+  }
+  return num_done;
+}
+
+void player::BatchAnalyzer::writeResult(std::ostream &output, const Result &result) {
+  output << result.index;
+  if (!result.valid) {
+    output << " invalid" << std::endl;
+    return;
+  }
+
+  output << " " << (result.principal_variation.empty() ? "none": result.principal_variation[0].toLongAlgebraic())
+         << " " << result.score << " " << result.depth << " " << result.nodes << " "
+         << (long) (result.elapsed * 1000.0);
+  for (std::size_t i = 1; i < result.principal_variation.size(); ++i)
+    output << " " << result.principal_variation[i].toLongAlgebraic();
+  output << std::endl;
+}
+
+bool player::BatchAnalyzer::nextPosition(std::size_t worker_id, std::size_t *index) {
+  Worker *worker = _workers[worker_id];
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (!worker->queue.empty()) {
+      *index = worker->queue.front();
+      worker->queue.pop_front();
+      return true;
+    }
+  }
+
+  // steal from the back of the next worker that still has positions left -> the owner keeps working from the front
+  for (std::size_t i = 1; i < _workers.size(); ++i) {
+    Worker *victim = _workers[(worker_id + i) % _workers.size()];
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->queue.empty()) {
+      *index = victim->queue.back();
+      victim->queue.pop_back();
+      return true;
+    }
+  }
+  return false; // every queue is empty -> positions never get added back, so this worker is done
+}
+
+void player::BatchAnalyzer::analyzePosition(Worker *worker, std::size_t index, Result *result) {
+  result->index = index;
+  piece::PieceColor color = piece::PieceColor::WHITE;
+  result->valid = worker->board->loadFromFEN((*_fens)[index], &color);
+  if (!result->valid)
+    return;
+
+  // the engine needs at least one move to search -> game over positions are scored here
+  std::vector<game::Move> moves;
+  worker->board->getCachedMoves(color, &moves);
+  if (moves.empty()) {
+    result->score = worker->board->isKingSafe(color) ? 0: -SearchEngine::MATE_SCORE;
+    return;
+  }
+
+  // every position gets the full budget -> a fresh clock each time
+  // w/o any time control the engine's own budget (config.max_depth) bounds the search, not an empty clock
+  TimeManager time_manager(_limits.clock, _limits.increment);
+  SearchLimits clock_limits = _limits;
+  clock_limits.infinite = !_limits.hasTimeControl();
+  time_manager.startMove(clock_limits);
+  worker->engine->search(worker->board, color, _limits, &time_manager, [] { return false; });
+  time_manager.endMove();
+
+  const SearchStatistics &statistics = worker->engine->lastSearchStatistics();
+  result->score = worker->engine->lastSearchLines()[0].score;
+  result->depth = statistics.depth;
+  result->nodes = statistics.nodes;
+  result->elapsed = statistics.elapsed;
+  result->principal_variation = worker->engine->principalVariation();
+}
+
+void player::BatchAnalyzer::work(BatchAnalyzer *analyzer, std::size_t worker_id, std::atomic_int &finished_count) {
+  Worker *worker = analyzer->_workers[worker_id];
+  std::size_t index;
+  while (analyzer->nextPosition(worker_id, &index)) {
+    Result result;
+    analyzer->analyzePosition(worker, index, &result);
+
+    std::lock_guard<std::mutex> lock(analyzer->_result_mutex);
+    (*analyzer->_on_result)(result);
+  }
+
+  ++finished_count;
+}
@@ -0,0 +1,139 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_BATCH_ANALYSIS_H_
+#define CHESS_AI_PLAYER_BATCH_ANALYSIS_H_
+
+#include "batch_analysis.fwd.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "../chess/game.h"
+#include "search.h"
+
+namespace player {
+
+// The PositionFile class: See batch_analysis.fwd.h
+// Binary layout -> Header, then Header::position_count records (the format is picked by the magic, so either can be read)
+// Records hold exactly what a FEN does, minus the move counters
+class PositionFile {
+  public:
+    class Header {
+      public:
+        char magic[8]; // see MAGIC
+        uint64_t position_count;
+    };
+
+    class Record {
+      public:
+        uint8_t squares[32]; // square r * 8 + c in the low nibble of byte i / 2 for even i -> 0 empty, 1-6 white, 9-14 black
+        uint8_t flags;       // bit 0 -> black to move, bits 1-4 -> castling rights K, Q, k, q
+        uint8_t en_passant;  // square behind the pawn that just moved 2x -> NO_SQUARE if none
+        uint8_t unused[2];
+    };
+
+    PositionFile() = delete;
+    PositionFile(const PositionFile &pf) = delete;
+    PositionFile &operator=(const PositionFile &pf) = delete;
+
+    // appends the file's positions (as FENs) -> false if it can't be read
+    static bool read(const std::string &file_path, std::vector<std::string> *fens);
+    // binary -> returns # of positions written (-1 on failure, malformed FENs are skipped)
+    static long write(const std::string &file_path, const std::vector<std::string> &fens);
+
+    static bool pack(const std::string &fen, Record *record); // false if the fen is malformed
+    static std::string unpack(const Record &record);
+
+    static const char MAGIC[8];
+    static const uint8_t NO_SQUARE = 0xFF;
+};
+
+// The BatchAnalyzer class: See batch_analysis.fwd.h
+// Every worker owns a search engine (single threaded -> the parallelism is across positions) && a board, both kept
+// from one position to the next, so the tables stay allocated (&& warm, for related positions)
+// Positions are dealt out in contiguous runs; a worker that runs out steals from the back of another's run
+class BatchAnalyzer {
+  public:
+    class Result {
+      public:
+        std::size_t index = 0;  // of the position in the input
+        bool valid = false;     // false -> the FEN couldn't be read
+        int score = 0;          // from the view of the side to move (see SearchEngine::MATE_SCORE)
+        int depth = 0;
+        long nodes = 0;
+        double elapsed = 0.0;   // in seconds
+        std::vector<game::Move> principal_variation; // best move first -> empty if the game is over
+    };
+
+    BatchAnalyzer() = delete;
+    BatchAnalyzer(const BatchAnalyzer &ba) = delete;
+    BatchAnalyzer &operator=(const BatchAnalyzer &ba) = delete;
+
+    // limits apply to each position on its own (ie a clock is the clock for every position)
+    BatchAnalyzer(const SearchConfig &config, const SearchLimits &limits, int num_threads);
+    ~BatchAnalyzer();
+
+    // on_result is called once per position as soon as it is done, never by 2 workers at once
+    void analyze(const std::vector<std::string> &fens, const std::function<void(const Result &)> &on_result);
+    // positions file (see PositionFile) -> one line per position, in the order they finish (see writeResult(...))
+    // returns # of positions analyzed (-1 if the positions can't be read or the output can't be written)
+    long run(const std::string &positions_file_path, const std::string &output_file_path, bool print_progress = true);
+
+    [[nodiscard]] inline int numThreads() const { return (int) _workers.size(); }
+
+    // "<index> <best move> <score> <depth> <nodes> <ms> <pv...>" -> best move is "none" if the game is over,
+    // "invalid" if the position couldn't be read
+    static void writeResult(std::ostream &output, const Result &result);
+
+  private:
+    class Worker {
+      public:
+        SearchEngine *engine;
+        game::Board *board;
+        std::deque<std::size_t> queue; // own positions -> taken from the front by the worker, from the back by thieves
+        std::mutex mutex;
+    };
+
+    SearchLimits _limits;
+    std::vector<Worker *> _workers;
+
+    const std::vector<std::string> *_fens;
+    const std::function<void(const Result &)> *_on_result;
+    std::mutex _result_mutex;
+
+    bool nextPosition(std::size_t worker_id, std::size_t *index);
+    void analyzePosition(Worker *worker, std::size_t index, Result *result);
+    static void work(BatchAnalyzer *analyzer, std::size_t worker_id, std::atomic_int &finished_count);
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_BATCH_ANALYSIS_H_
@@ -0,0 +1,295 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "mate_search.h"
+
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+#include "../chess/zobrist.h"
+#include "../util/assert_util.h"
+
+int player::MateSearch::DEFAULT_SIZE_IN_MB = 16;
+
+static_assert(2 * player::MateSearch::MAX_MOVES <= UINT8_MAX, "plies to mate must fit in Entry::plies");
+
+player::MateSearch::MateSearch(int size_in_mb) {
+  if (size_in_mb <= 0) {
+    DEBUG_ASSERT
+    size_in_mb = 1;
+  }
+
+  // largest power of 2 that fits in the requested memory (at least one bucket)
+  std::size_t max_entries = ((std::size_t) size_in_mb << 20U) / sizeof(Entry);
+  _size = BUCKET_SIZE;
+  while (_size * 2 <= max_entries)
+    _size *= 2;
+
+  _entries = new Entry[_size];
+  _index_mask = (_size - 1) & ~(uint64_t) (BUCKET_SIZE - 1);
+  clear();
+
+  _board = nullptr;
+  _attacker = piece::PieceColor::NONE;
+  _nodes = _max_nodes = 0;
+}
+
+player::MateSearch::~MateSearch() {
+  delete[] _entries;
+}
+
+void player::MateSearch::clear() {
+  for (std::size_t i = 0; i < _size; ++i)
+    _entries[i] = {0, 1, 1, 0, 0, 0};
+}
+
+player::MateSearch::Result player::MateSearch::search(const game::Board *board, piece::PieceColor color,
+                                                      int max_moves, long max_nodes) {
+  auto start = std::chrono::steady_clock::now();
+  Result result;
+
+  // the table is only valid for one attacker && one root -> keys don't say whose mate a proof is about
+  clear();
+  _board = board->clone();
+  _board->set_pawn_upgrade_type(piece::PieceType::QUEEN);
+  _attacker = color;
+  _nodes = 0;
+  _max_nodes = std::max(max_nodes, 0L);
+
+  uint64_t root_key = _board->hash() ^ zobrist::color_key(color);
+  int moves;
+  for (moves = 1; moves <= std::min(max_moves, MAX_MOVES); ++moves) {
+    int remaining = 2 * moves - 1; // the attacker's last move mates -> no reply left to search
+    multipleIterativeDeepening(color, remaining, INFINITE_PROOF, INFINITE_PROOF);
+
+    Bounds root = lookup(root_key, remaining);
+    if (root.proof == 0) {
+      result.outcome = Result::MATE;
+      result.moves = moves;
+      _max_nodes = 0; // the proven line is worth finishing, even past the budget
+      extractLine(color, remaining, &result.line);
+      break;
+    }
+    if (root.disproof != 0) // neither proven nor disproven -> out of nodes
+      break;
+  }
+  if (result.outcome != Result::MATE && moves > std::min(max_moves, MAX_MOVES))
+    result.outcome = Result::NO_MATE;
+
+  result.nodes = _nodes;
+  result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  delete _board;
+  _board = nullptr;
+  return result;
+}
+
+std::string player::MateSearch::Result::toString() const {
+  std::ostringstream output;
+  if (outcome == MATE) {
+    output << "mate in " << moves << ":";
+    for (const game::Move &move : line)
+      output << " " << move.toLongAlgebraic();
+  } else if (outcome == NO_MATE) {
+    output << "no mate";
+  } else {
+    output << "unknown (node limit)";
+  }
+  output << " (" << nodes << " nodes, " << (long) (elapsed * 1000.0) << " ms)";
+  return output.str();
+}
+
+void player::MateSearch::multipleIterativeDeepening(piece::PieceColor color, int remaining, uint32_t proof_threshold,
+                                                    uint32_t disproof_threshold) {
+  uint64_t key = _board->hash() ^ zobrist::color_key(color);
+  long start_nodes = _nodes++;
+
+  std::vector<game::Move> moves;
+  Bounds bounds{};
+  if (isTerminal(color, remaining, &moves, &bounds)) {
+    store(key, remaining, bounds, 1);
+    return;
+  }
+
+  // children are looked up again after every expansion -> keys once, not a move per lookup
+  std::vector<uint64_t> child_keys(moves.size());
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    _board->doMove(moves[i], nullptr);
+    child_keys[i] = _board->hash() ^ zobrist::color_key(!color);
+    _board->undoMove(nullptr);
+  }
+
+  bool attacking = color == _attacker;
+  while (true) {
+    // or node -> proof = min, disproof = sum, and node -> the other way around
+    // the most-proving child has the smallest proof (or node) or disproof (and node) number
+    uint32_t best = INFINITE_PROOF, second = INFINITE_PROOF, sum = 0;
+    std::size_t best_index = 0;
+    int plies = attacking ? MAX_MOVES * 2: 0;
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      Bounds child = lookup(child_keys[i], remaining - 1);
+      uint32_t selected = attacking ? child.proof: child.disproof, other = attacking ? child.disproof: child.proof;
+      sum = std::min(sum + other, INFINITE_PROOF);
+      if (selected < best) {
+        second = best;
+        best = selected;
+        best_index = i;
+      } else if (selected < second) {
+        second = selected;
+      }
+
+      // attacker picks the quickest mate it has proven, the defender the slowest
+      if (child.proof == 0)
+        plies = attacking ? std::min(plies, child.plies): std::max(plies, child.plies);
+    }
+
+    bounds = attacking ? Bounds{best, sum, plies + 1}: Bounds{sum, best, plies + 1};
+    store(key, remaining, bounds, (uint32_t) std::min(_nodes - start_nodes, (long) UINT32_MAX));
+    if (bounds.proof >= proof_threshold || bounds.disproof >= disproof_threshold || isOutOfNodes())
+      return;
+
+    // the child's thresholds -> it gets searched until it is no longer the most-proving child (second + 1),
+    // or until this node would reach its own threshold
+    Bounds child = lookup(child_keys[best_index], remaining - 1);
+    uint32_t child_proof_threshold, child_disproof_threshold;
+    if (attacking) {
+      child_proof_threshold = std::min(proof_threshold, second + 1);
+      child_disproof_threshold = std::min(disproof_threshold - bounds.disproof + child.disproof, INFINITE_PROOF);
+    } else {
+      child_proof_threshold = std::min(proof_threshold - bounds.proof + child.proof, INFINITE_PROOF);
+      child_disproof_threshold = std::min(disproof_threshold, second + 1);
+    }
+
+    _board->doMove(moves[best_index], nullptr);
+    multipleIterativeDeepening(!color, remaining - 1, child_proof_threshold, child_disproof_threshold);
+    _board->undoMove(nullptr);
+  }
+}
+
+bool player::MateSearch::isTerminal(piece::PieceColor color, int remaining, std::vector<game::Move> *moves,
+                                    Bounds *bounds) {
+  bool attacking = color == _attacker;
+  if (attacking && remaining <= 0) { // no moves left to mate w/
+    *bounds = {INFINITE_PROOF, 0, 0};
+    return true;
+  }
+
+  _board->getCachedMoves(color, moves);
+  if (moves->empty()) {
+    // defender w/o moves -> mated if in check, stalemated (a draw -> not a mate) otherwise
+    bool mated = !attacking && !_board->isKingSafe(color);
+    *bounds = mated ? Bounds{0, INFINITE_PROOF, 0}: Bounds{INFINITE_PROOF, 0, 0};
+    return true;
+  }
+
+  if (remaining <= 0) { // defender still has moves after the attacker's last one
+    *bounds = {INFINITE_PROOF, 0, 0};
+    return true;
+  }
+  return false;
+}
+
+void player::MateSearch::extractLine(piece::PieceColor color, int remaining, std::vector<game::Move> *line) {
+  int played = 0;
+  std::vector<game::Move> moves;
+  Bounds bounds{};
+  while (!isTerminal(color, remaining, &moves, &bounds)) {
+    bool attacking = color == _attacker;
+    std::size_t best_index = moves.size();
+    for (int attempt = 0; attempt < 2 && best_index == moves.size(); ++attempt) {
+      if (attempt > 0) // part of the proof tree was replaced -> prove this node again
+        multipleIterativeDeepening(color, remaining, INFINITE_PROOF, INFINITE_PROOF);
+
+      // attacker -> quickest proven mate, defender -> slowest (every reply is proven if the node is)
+      int best_plies = 0;
+      for (std::size_t i = 0; i < moves.size(); ++i) {
+        _board->doMove(moves[i], nullptr);
+        Bounds child = lookup(_board->hash() ^ zobrist::color_key(!color), remaining - 1);
+        _board->undoMove(nullptr);
+
+        if (child.proof != 0) {
+          if (!attacking) { // unproven reply -> can't pick the defender's move yet
+            best_index = moves.size();
+            break;
+          }
+          continue;
+        }
+        if (best_index == moves.size() || (attacking ? child.plies < best_plies: child.plies > best_plies)) {
+          best_index = i;
+          best_plies = child.plies;
+        }
+      }
+    }
+    if (best_index == moves.size()) {
+      DEBUG_ASSERT // -> the node isn't proven after all
+      break;
+    }
+
+    line->push_back(moves[best_index]);
+    _board->doMove(moves[best_index], nullptr);
+    ++played;
+    color = !color;
+    --remaining;
+    moves.clear();
+  }
+
+  for (int i = 0; i < played; ++i)
+    _board->undoMove(nullptr);
+}
+
+player::MateSearch::Bounds player::MateSearch::lookup(uint64_t key, int remaining) const {
+  const Entry *bucket = _entries + (key & _index_mask);
+  for (std::size_t i = 0; i < BUCKET_SIZE; ++i) {
+    const Entry &entry = bucket[i];
+    if (entry.key != key)
+      continue;
+
+    // proofs hold w/ more plies left, disproofs w/ fewer -> anything else only for the same plies
+    if (entry.proof == 0 && entry.plies <= remaining)
+      return {0, INFINITE_PROOF, entry.plies};
+    if (entry.disproof == 0 && entry.remaining >= remaining)
+      return {INFINITE_PROOF, 0, 0};
+    if (entry.proof != 0 && entry.disproof != 0 && entry.remaining == remaining)
+      return {entry.proof, entry.disproof, 0};
+  }
+  return {1, 1, 0};
+}
+
+void player::MateSearch::store(uint64_t key, int remaining, const Bounds &bounds, uint32_t work) {
+  // one entry per key && plies left -> same entry first, then an empty one, then the one w/ the least work behind it
+  Entry *bucket = _entries + (key & _index_mask);
+  Entry *target = bucket;
+  for (std::size_t i = 0; i < BUCKET_SIZE; ++i) {
+    Entry &entry = bucket[i];
+    if (entry.key == key && entry.remaining == remaining) {
+      target = &entry;
+      work = std::max(work, entry.work);
+      break;
+    }
+    if (entry.work < target->work)
+      target = &entry;
+  }
+
+  *target = {key, bounds.proof, bounds.disproof, work, (int16_t) remaining, (uint8_t) bounds.plies};
+}
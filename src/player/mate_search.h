@@ -0,0 +1,123 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_MATE_SEARCH_H_
+#define CHESS_AI_PLAYER_MATE_SEARCH_H_
+
+#include "mate_search.fwd.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "../chess/piece.h"
+#include "../chess/game.h"
+
+namespace player {
+
+// The MateSearch class: See mate_search.fwd.h
+// The attacker's nodes are OR nodes (one mating move proves them), the defender's are AND nodes (every reply must
+// be mated) -> the search always expands the most-proving child, the one w/ the fewest nodes left to (dis)prove
+// Depth limited, in plies: a mate in n is searched w/ n = 1, 2... so the first proof found is also the shortest
+// Proofs && disproofs are kept in the table across iterations (a mate in 2 is a mate in 3, no mate in 3 -> none in 2)
+// The table never grows after construction -> once it is full, the entries w/ the least work behind them go first
+class MateSearch {
+  public:
+    class Entry {
+      public:
+        uint64_t key;
+        uint32_t proof, disproof; // 0 proof -> mate found, 0 disproof -> no mate w/in remaining plies
+        uint32_t work;            // nodes expanded below this one -> replacement priority
+        int16_t remaining;        // plies it was searched w/ -> up to 2 * MAX_MOVES - 1
+        uint8_t plies;            // proven -> plies to mate, up to 2 * MAX_MOVES
+    };
+
+    class Result {
+      public:
+        enum Outcome {
+          MATE, NO_MATE, UNKNOWN // UNKNOWN -> the node budget ran out first
+        };
+
+        Outcome outcome = UNKNOWN;
+        int moves = 0;                  // MATE -> mate in this many moves of the attacker
+        std::vector<game::Move> line;   // MATE -> attacker's mating moves vs the defender's longest resistance
+        long nodes = 0;
+        double elapsed = 0.0;           // in seconds
+
+        [[nodiscard]] std::string toString() const; // one line, for logs
+    };
+
+    MateSearch() = delete;
+    MateSearch(const MateSearch &ms) = delete;
+    MateSearch &operator=(const MateSearch &ms) = delete;
+
+    explicit MateSearch(int size_in_mb);
+    ~MateSearch();
+
+    // shortest forced mate by color (to move) in at most max_moves of its moves -> max_nodes = 0 -> no node limit
+    Result search(const game::Board *board, piece::PieceColor color, int max_moves, long max_nodes = 0);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    static int DEFAULT_SIZE_IN_MB;
+
+    static constexpr int MAX_MOVES = 100; // in moves of the attacker -> plies have to fit in Entry::remaining && plies
+    static constexpr uint32_t INFINITE_PROOF = 100000000; // proof/disproof numbers are capped here
+
+  private:
+    // proof && disproof numbers of a node, looked up for the plies it has left
+    class Bounds {
+      public:
+        uint32_t proof, disproof;
+        int plies; // proven -> plies to mate
+    };
+
+    static const std::size_t BUCKET_SIZE = 4; // entries a key can go in
+
+    Entry *_entries;
+    std::size_t _size;
+    uint64_t _index_mask; // of the first entry of a bucket
+
+    game::Board *_board;
+    piece::PieceColor _attacker;
+    long _nodes, _max_nodes;
+
+    // expands the node until its proof number reaches proof_threshold or its disproof number disproof_threshold
+    void multipleIterativeDeepening(piece::PieceColor color, int remaining, uint32_t proof_threshold,
+                                    uint32_t disproof_threshold);
+    // true if the node is decided w/o looking at its children (mated, stalemated, out of plies) -> bounds are set
+    bool isTerminal(piece::PieceColor color, int remaining, std::vector<game::Move> *moves, Bounds *bounds);
+    // follows the proof tree from the root -> any part of it that was replaced in the table is proven again
+    void extractLine(piece::PieceColor color, int remaining, std::vector<game::Move> *line);
+
+    [[nodiscard]] Bounds lookup(uint64_t key, int remaining) const; // 1, 1 for unknown nodes
+    void store(uint64_t key, int remaining, const Bounds &bounds, uint32_t work);
+    [[nodiscard]] inline bool isOutOfNodes() const { return _max_nodes > 0 && _nodes >= _max_nodes; }
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_MATE_SEARCH_H_
@@ -0,0 +1,272 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "opening_book.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../chess/piece.h"
+#include "../chess/game.h"
+#include "../chess/zobrist.h"
+#include "../util/math_util.h"
+#include "../util/assert_util.h"
+
+const char player::OpeningBook::MAGIC[8] = {'C', 'A', 'I', 'B', 'O', 'O', 'K', '1'};
+
+std::mutex player::OpeningBookBuilder::record_mutex;
+
+// OpeningBook class
+player::OpeningBook::OpeningBook(const std::string &file_path, Policy policy) {
+  _mapping = nullptr;
+  _mapping_size = 0;
+  _entries = nullptr;
+  _size = 0;
+  _policy = policy;
+
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return; // no book -> every probe misses
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t) sizeof(Header)) {
+    void *mapping = mmap(nullptr, (std::size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      _mapping = mapping;
+      _mapping_size = (std::size_t) file_stat.st_size;
+    }
+  }
+  close(fd); // the mapping stays valid w/o the descriptor
+
+  if (_mapping == nullptr)
+    return;
+
+  const auto *header = (const Header *) _mapping;
+  std::size_t expected_size = sizeof(Header) + header->entry_count * sizeof(Entry);
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || expected_size != _mapping_size) {
+    DEBUG_ASSERT // -> not a book file (or a truncated one)
+    munmap(_mapping, _mapping_size);
+    _mapping = nullptr;
+    _mapping_size = 0;
+    return;
+  }
+
+  _entries = (const Entry *) ((const char *) _mapping + sizeof(Header));
+  _size = header->entry_count;
+}
+
+player::OpeningBook::~OpeningBook() {
+  if (_mapping != nullptr)
+    munmap(_mapping, _mapping_size);
+}
+
+std::vector<player::OpeningBook::Entry> player::OpeningBook::probe(uint64_t key) const {
+  if (_entries == nullptr)
+    return {};
+
+  const Entry *end = _entries + _size;
+  const Entry *first = std::lower_bound(_entries, end, key, [](const Entry &e, uint64_t k) { return e.key < k; });
+
+  const Entry *last = first;
+  while (last != end && last->key == key)
+    ++last;
+  return std::vector<Entry>(first, last);
+}
+
+std::vector<player::OpeningBook::Entry> player::OpeningBook::probe(const game::Board *board,
+                                                                   piece::PieceColor color) const {
+  return probe(board->hash() ^ zobrist::color_key(color));
+}
+
+bool player::OpeningBook::pickMove(game::Game *game, piece::PieceColor color, game::Move *move) const {
+  std::vector<Entry> entries = probe(game->board(), color);
+  if (entries.empty())
+    return false;
+
+  // only keep moves that are legal here -> a hash collision must never play an illegal move
+  std::vector<game::Move> legal_moves = game->possibleMoves(color);
+  std::vector<std::pair<Entry, game::Move>> candidates;
+  for (const Entry &entry : entries)
+    for (const game::Move &legal_move : legal_moves)
+      if (legal_move.pack() == entry.move) {
+        candidates.emplace_back(entry, legal_move);
+        break;
+      }
+  if (candidates.empty())
+    return false;
+
+  if (_policy == BEST) {
+    auto best = std::max_element(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+      double score_a = a.first.averageScore(), score_b = b.first.averageScore();
+      return score_a < score_b || (score_a == score_b && a.first.games < b.first.games);
+    });
+    *move = best->second;
+    return true;
+  }
+
+  // WEIGHTED_RANDOM
+  double total_games = 0;
+  for (const auto &candidate : candidates)
+    total_games += candidate.first.games;
+
+  double target = math::random(total_games);
+  for (const auto &candidate : candidates) {
+    target -= candidate.first.games;
+    if (target < 0) {
+      *move = candidate.second;
+      return true;
+    }
+  }
+  *move = candidates.back().second; // rounding -> last move
+  return true;
+}
+
+// OpeningBookBuilder class
+player::OpeningBookBuilder::OpeningBookBuilder(int max_ply, int min_games, std::string start_board_file_path) {
+  _max_ply = max_ply;
+  _min_games = std::max(min_games, 1);
+  _start_board_file_path = std::move(start_board_file_path);
+  _games = 0;
+}
+
+player::OpeningBookBuilder::~OpeningBookBuilder() = default;
+
+void player::OpeningBookBuilder::addGame(const std::vector<game::Move> &moves, game::GameResult result) {
+  if (result.isGameUndecided())
+    return; // unfinished game -> nothing to learn from
+
+  // replayed through a game -> every move is checked for legality, not just for its color
+  auto *game = new game::Game(new game::Board(8, 8));
+  game->board()->loadFromFile(_start_board_file_path);
+  game->updateGameState();
+
+  int plies = std::min((int) moves.size(), _max_ply);
+  for (int ply = 0; ply < plies && !game->isOver(); ++ply) {
+    piece::PieceColor color = game->getCurrentColor();
+
+    const game::Move &move = moves[ply];
+    if (!game->isLegalMove(move) || game->getPiece(move.startingRow(), move.startingColumn())->color() != color) {
+      DEBUG_ASSERT // -> record doesn't match the start position (or is corrupt)
+      break;
+    }
+
+    uint32_t points = result.isStalemate() ? 1: (result.isWhiteWin() == color.isWhite() ? 2: 0);
+    Statistics &statistics = _statistics[{game->board()->hash() ^ zobrist::color_key(color), move.pack()}];
+    ++statistics.games;
+    statistics.points += points;
+
+    // promotions -> the piece the record names, or a queen (what the players pick) if it names none
+    piece::PieceType promotion = move.pawn_promotion_type();
+    if (promotion.isEmpty())
+      promotion = piece::PieceType::QUEEN;
+    game->board()->set_pawn_upgrade_type(promotion);
+    game->applyMove(move);
+  }
+
+  delete game;
+  ++_games;
+}
+
+int player::OpeningBookBuilder::addGameRecords(const std::string &file_path) {
+  std::ifstream in_stream(file_path);
+  if (!in_stream.is_open()) {
+    DEBUG_ASSERT
+    return 0;
+  }
+
+  int count = 0;
+  std::string line;
+  while (std::getline(in_stream, line)) {
+    std::istringstream line_stream(line);
+    std::string result_string;
+    int move_count;
+    if (!(line_stream >> result_string >> move_count))
+      continue; // blank/malformed line
+
+    game::GameResult result = game::GameResult::NONE;
+    if (result_string == game::GameResult(game::GameResult::WHITE).toString())
+      result = game::GameResult::WHITE;
+    else if (result_string == game::GameResult(game::GameResult::BLACK).toString())
+      result = game::GameResult::BLACK;
+    else if (result_string == game::GameResult(game::GameResult::STALEMATE).toString())
+      result = game::GameResult::STALEMATE;
+
+    std::vector<game::Move> moves;
+    unsigned packed;
+    while ((int) moves.size() < move_count && line_stream >> packed)
+      moves.push_back(game::Move::unpack((uint16_t) packed));
+
+    addGame(moves, result);
+    ++count;
+  }
+  return count;
+}
+
+long player::OpeningBookBuilder::write(const std::string &file_path) const {
+  std::vector<OpeningBook::Entry> entries;
+  for (const auto &it : _statistics) // map order == (key, move) order
+    if (it.second.games >= (uint32_t) _min_games)
+      entries.push_back({it.first.first, it.second.games, it.second.points, it.first.second, {0, 0, 0}});
+
+  std::ofstream out_stream(file_path, std::ios::binary | std::ios::trunc);
+  if (!out_stream.is_open()) {
+    DEBUG_ASSERT
+    return -1;
+  }
+
+  OpeningBook::Header header{};
+  std::memcpy(header.magic, OpeningBook::MAGIC, sizeof(header.magic));
+  header.entry_count = entries.size();
+
+  out_stream.write((const char *) &header, sizeof(header));
+  out_stream.write((const char *) entries.data(), (std::streamsize) (entries.size() * sizeof(OpeningBook::Entry)));
+  if (!out_stream) {
+    DEBUG_ASSERT
+    return -1;
+  }
+  return (long) entries.size();
+}
+
+void player::OpeningBookBuilder::appendGameRecord(const std::string &file_path, const game::Board *board,
+                                                  game::GameResult result) {
+  std::vector<game::Move> moves = board->moveHistory();
+
+  std::ostringstream line;
+  line << result.toString() << " " << moves.size();
+  for (const game::Move &move : moves)
+    line << " " << move.pack();
+
+  std::lock_guard<std::mutex> lock(record_mutex);
+  std::ofstream out_stream(file_path, std::ios::app);
+  if (out_stream.is_open())
+    out_stream << line.str() << std::endl;
+  else DEBUG_ASSERT
+}
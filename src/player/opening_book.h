@@ -0,0 +1,142 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_OPENING_BOOK_H_
+#define CHESS_AI_PLAYER_OPENING_BOOK_H_
+
+#include "opening_book.fwd.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+#include "../chess/piece.fwd.h"
+#include "../chess/game.fwd.h"
+
+namespace player {
+
+// The OpeningBook class: See opening_book.fwd.h
+// File layout -> Header, then Header::entry_count entries sorted by (key, move)
+// The file is mapped as is, so opening a book costs no parsing && probes are a binary search over the mapping
+// The mapping is read-only after construction -> safe to share between players/threads
+class OpeningBook {
+  public:
+    enum Policy {
+      BEST,           // highest average score for the side to move, ties broken by games played
+      WEIGHTED_RANDOM // random move, weighted by how often it was played
+    };
+
+    class Header {
+      public:
+        char magic[8]; // see MAGIC
+        uint64_t entry_count;
+    };
+
+    class Entry {
+      public:
+        uint64_t key;    // board hash ^ zobrist::color_key(side to move)
+        uint32_t games;  // games in which the side to move played move here
+        uint32_t points; // half-points scored by the side to move in those games (win = 2, draw = 1)
+        uint16_t move;   // see game::Move::pack()
+        uint16_t unused[3];
+
+        [[nodiscard]] inline double averageScore() const { return games == 0 ? 0.0: points / (2.0 * games); }
+    };
+
+    OpeningBook() = delete;
+    OpeningBook(const OpeningBook &book) = delete;
+    OpeningBook &operator=(const OpeningBook &book) = delete;
+
+    explicit OpeningBook(const std::string &file_path, Policy policy = WEIGHTED_RANDOM);
+    ~OpeningBook();
+
+    [[nodiscard]] inline bool isOpen() const { return _entries != nullptr; }
+    [[nodiscard]] inline std::size_t size() const { return _size; }
+    [[nodiscard]] inline Policy policy() const { return _policy; }
+
+    // entries for the position -> empty if it isn't in the book
+    [[nodiscard]] std::vector<Entry> probe(uint64_t key) const;
+    [[nodiscard]] std::vector<Entry> probe(const game::Board *board, piece::PieceColor color) const;
+
+    // picks a book move for the side to move w/ the book's policy -> false if the position isn't in the book
+    bool pickMove(game::Game *game, piece::PieceColor color, game::Move *move) const;
+
+    static const char MAGIC[8];
+
+  private:
+    void *_mapping;
+    std::size_t _mapping_size;
+    const Entry *_entries; // nullptr if the file couldn't be mapped
+    std::size_t _size;
+    Policy _policy;
+};
+
+// The OpeningBookBuilder class: See opening_book.fwd.h
+// Game records are plain text, one game per line -> "<result> <move count> <packed move>..." (see Move::pack())
+// Every game is replayed from the default start position and each of its first max_ply moves is counted
+class OpeningBookBuilder {
+  public:
+    OpeningBookBuilder() = delete;
+    OpeningBookBuilder(const OpeningBookBuilder &builder) = delete;
+    OpeningBookBuilder &operator=(const OpeningBookBuilder &builder) = delete;
+
+    explicit OpeningBookBuilder(int max_ply = 20, int min_games = 2,
+                                std::string start_board_file_path = "assets/game_states/chess_default_start.txt");
+    ~OpeningBookBuilder();
+
+    void addGame(const std::vector<game::Move> &moves, game::GameResult result);
+    int addGameRecords(const std::string &file_path); // returns # of games read
+
+    // moves played in fewer than min_games games are left out -> returns # of entries written (-1 on failure)
+    long write(const std::string &file_path) const;
+
+    [[nodiscard]] inline int games() const { return _games; }
+
+    // appends the game played on the board to a record file -> safe to call from several games at once
+    static void appendGameRecord(const std::string &file_path, const game::Board *board, game::GameResult result);
+
+  private:
+    class Statistics {
+      public:
+        uint32_t games;
+        uint32_t points;
+    };
+
+    int _max_ply;
+    int _min_games;
+    std::string _start_board_file_path;
+
+    int _games;
+    std::map<std::pair<uint64_t, uint16_t>, Statistics> _statistics; // (key, packed move) -> sorted like the file
+
+    static std::mutex record_mutex;
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_OPENING_BOOK_H_
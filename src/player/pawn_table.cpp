@@ -0,0 +1,115 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "pawn_table.h"
+
+#include "../chess/game.h"
+#include "../util/assert_util.h"
+
+int player::PawnTable::DEFAULT_SIZE_IN_KB = 256;
+
+player::PawnTable::PawnTable(int size_in_kb) {
+  if (size_in_kb <= 0) {
+    DEBUG_ASSERT
+    size_in_kb = 1;
+  }
+
+  // largest power of 2 that fits in the requested memory
+  std::size_t max_entries = ((std::size_t) size_in_kb << 10U) / sizeof(Entry);
+  _size = 1;
+  while (_size * 2 <= max_entries)
+    _size *= 2;
+
+  _entries = new Entry[_size];
+  _index_mask = _size - 1;
+  clear();
+}
+
+player::PawnTable::~PawnTable() {
+  delete[] _entries;
+}
+
+int player::PawnTable::score(const game::Board *board, piece::PieceColor color, bool *hit) {
+  uint64_t key = board->pawnHash();
+  Entry &entry = _entries[key & _index_mask];
+  *hit = entry.key == key;
+  if (!*hit) {
+    entry.key = key;
+    evaluate(board, entry.terms);
+  }
+
+  // whole pawns only (the evaluator's units) -> quarters only count once they add up
+  return (entry.terms[color] - entry.terms[!color]) / TERM_SCALE;
+}
+
+void player::PawnTable::clear() {
+  // key 0 is the position w/o pawns, which has no terms anyway
+  for (std::size_t i = 0; i < _size; ++i)
+    _entries[i] = {0, {0, 0}};
+}
+
+void player::PawnTable::evaluate(const game::Board *board, int16_t *terms) {
+  terms[piece::PieceColor::BLACK] = terms[piece::PieceColor::WHITE] = 0;
+  if (board->length() != 8 || board->width() != 8)
+    return;
+
+  // square r * 8 + c -> one bitboard of pawns per color
+  uint64_t pawns[2] = {0, 0};
+  board->forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+    if (piece->type().isPawn())
+      pawns[piece->color()] |= 1ULL << (unsigned) (r * 8 + c);
+  });
+
+  const uint64_t FILE = 0x0101010101010101ULL;
+  for (int color = piece::PieceColor::BLACK; color <= piece::PieceColor::WHITE; ++color) {
+    uint64_t own = pawns[color], enemy = pawns[1 - color];
+    int term = 0;
+    for (int c = 0; c < 8; ++c) {
+      uint64_t file = own & (FILE << (unsigned) c);
+      if (file == 0)
+        continue;
+
+      int count = __builtin_popcountll(file);
+      term += DOUBLED_PAWN * (count - 1);
+
+      uint64_t neighbors = (c > 0 ? FILE << (unsigned) (c - 1): 0) | (c < 7 ? FILE << (unsigned) (c + 1): 0);
+      if ((own & neighbors) == 0)
+        term += ISOLATED_PAWN * count;
+
+      // passed -> no enemy pawn ahead of it on its own file or the files next to it (white moves up the rows)
+      for (int r = 0; r < 8; ++r) {
+        if ((file >> (unsigned) (r * 8 + c) & 1U) == 0)
+          continue;
+
+        uint64_t ahead = 0;
+        for (int row = color == piece::PieceColor::WHITE ? r + 1: r - 1; 0 <= row && row < 8;
+             row += color == piece::PieceColor::WHITE ? 1: -1)
+          ahead |= 0xFFULL << (unsigned) (row * 8);
+        if ((enemy & ahead & ((FILE << (unsigned) c) | neighbors)) == 0)
+          term += PASSED_PAWN + (color == piece::PieceColor::WHITE ? r - 1: 6 - r);
+      }
+    }
+    terms[color] = (int16_t) term;
+  }
+}
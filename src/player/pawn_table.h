@@ -0,0 +1,81 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_PAWN_TABLE_H_
+#define CHESS_AI_PLAYER_PAWN_TABLE_H_
+
+#include "pawn_table.fwd.h"
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../chess/piece.h"
+#include "../chess/game.fwd.h"
+
+namespace player {
+
+// The PawnTable class: See pawn_table.fwd.h
+// Keyed by game::Board::pawnHash() -> pawns move (or get taken) in few of the moves searched, so siblings share entries
+// One table per search thread -> no sharing, no locks, the newest entry always replaces the old one
+// Terms are kept in quarter pawns per color && only turned into evaluator units (pawns) by score(...)
+class PawnTable {
+  public:
+    class Entry {
+      public:
+        uint64_t key;
+        int16_t terms[2]; // [PieceColor] -> sum of that color's pawn terms, in quarter pawns
+    };
+
+    PawnTable() = delete;
+    PawnTable(const PawnTable &pt) = delete;
+    PawnTable &operator=(const PawnTable &pt) = delete;
+
+    explicit PawnTable(int size_in_kb);
+    ~PawnTable();
+
+    // pawn structure of color minus that of the other color, in pawns -> hit is set iff it came from the table
+    int score(const game::Board *board, piece::PieceColor color, bool *hit);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    // doubled/isolated/passed pawn terms of both colors, from scratch (0 for boards that aren't 8x8)
+    static void evaluate(const game::Board *board, int16_t *terms);
+
+    static int DEFAULT_SIZE_IN_KB;
+
+    static const int DOUBLED_PAWN = -2;  // per pawn behind another pawn of the same color on its file
+    static const int ISOLATED_PAWN = -2; // per pawn w/o pawns of its color on the files next to it
+    static const int PASSED_PAWN = 1;    // + 1 per row it has advanced (no enemy pawn can stop it)
+    static const int TERM_SCALE = 4;     // terms per pawn
+
+  private:
+    Entry *_entries;
+    std::size_t _size;
+    uint64_t _index_mask;
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_PAWN_TABLE_H_
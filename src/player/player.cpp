@@ -27,14 +27,21 @@
 #include <string>
 #include <iostream>
 #include <vector>
-#include <set>
 #include <utility>
+#include <algorithm>
 
 #include "../chess/piece.h"
 #include "../chess/game.h"
 #include "../mcts_network/network.h"
 #include "../mcts_network/tree.h"
 #include "../util/thread_util.h"
+#include "transposition_table.h"
+#include "pawn_table.h"
+#include "time_manager.h"
+#include "search.h"
+#include "opening_book.h"
+#include "tablebase.h"
+#include "mate_search.h"
 
 // PlayerType class
 player::Player *player::PlayerType::getPlayerOfType(PlayerType type, game::Game *game, piece::PieceColor color) {
@@ -51,12 +58,17 @@ player::Player *player::PlayerType::getPlayerOfType(PlayerType type, game::Game
       return new MonteCarloPlayer(game, color);
     case AI:
       return new NetworkAIPlayer(game, color);
+    case AI_AB_PRUNING:
+      return new NetworkAlphaBetaPlayer(game, color);
 
     default: FATAL_ASSERT
   }
 }
 
 // Player class
+player::OpeningBook *player::Player::OPENING_BOOK = nullptr;
+player::SearchLimits player::Player::DEFAULT_SEARCH_LIMITS{};
+
 player::Player::Player(game::Game *g, piece::PieceColor c, PlayerType t) {
   _game = g;
   _board = g->board();
@@ -64,10 +76,41 @@ player::Player::Player(game::Game *g, piece::PieceColor c, PlayerType t) {
   _type = t;
 
   _move_count_at_start = -1;
+
+  _ponder_move = nullptr;
+  _ponder_move_count = -1;
+  _is_ponder_stopped = true;
+  _is_ponder_running = false;
+  _ponder_time_manager = new TimeManager(0.0, 0.0);
+
+  _search_limits = new SearchLimits();
+  _time_manager = nullptr;
+  setSearchLimits(DEFAULT_SEARCH_LIMITS);
 }
 // DO NOT DELETE BOARD OR GAME
-// nothing else to delete
-player::Player::~Player() = default;
+player::Player::~Player() {
+  delete _search_limits;
+  delete _time_manager;
+  delete _ponder_time_manager;
+}
+
+void player::Player::setSearchLimits(const SearchLimits &limits) {
+  stopPondering(); // the ponder search reads the limits too
+
+  *_search_limits = limits;
+  delete _time_manager;
+  if (limits.clock > 0.0)
+    _time_manager = new TimeManager(limits.clock, std::max(limits.increment, 0.0));
+  else
+    _time_manager = new TimeManager(TimeManager::DEFAULT_CLOCK_IN_SECONDS, TimeManager::DEFAULT_INCREMENT_IN_SECONDS);
+}
+const player::SearchLimits &player::Player::searchLimits() const {
+  return *_search_limits;
+}
+
+void player::Player::stop() {
+  _time_manager->stop();
+}
 
 void player::Player::playMove(const game::Move &m) {
   if (!moveOverByUndo()) {
@@ -87,11 +130,25 @@ void player::Player::playRandomMove() {
   playMove(moves[math::random((int) moves.size())]);
 }
 
+bool player::Player::playBookMove() {
+  if (OPENING_BOOK == nullptr || _type.isHumanPlayer() || _type.isRandomPlayer())
+    return false;
+
+  game::Move move = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+  if (!OPENING_BOOK->pickMove(_game, _color, &move))
+    return false;
+
+  stopPondering(); // a ponder search from before is of no use now (cleaned up by the next findAndPlayMove)
+  playMove(move);
+  return true;
+}
+
 void player::Player::playNextMove() {
   if (_move_count_at_start >= 0) DEBUG_ASSERT
 
   _move_count_at_start = _game->board()->move_count();
-  this->findAndPlayMove();
+  if (!playBookMove())
+    this->findAndPlayMove();
   _move_count_at_start = -1;
 }
 
@@ -102,6 +159,22 @@ bool player::Player::moveOver() const {
   return _game->isMoveOver() || moveOverByUndo();
 }
 
+bool player::Player::isPonderHit() const {
+  // stopped before the reply came (new limits, a book move...) -> the search was cut short, so it's a miss
+  if (_ponder_move == nullptr || _is_ponder_stopped || _board->move_count() != _ponder_move_count)
+    return false;
+
+  game::Move *last_move = _board->getLastMove();
+  bool hit = last_move != nullptr && *last_move == *_ponder_move;
+  delete last_move;
+  return hit;
+}
+
+void player::Player::stopPondering() {
+  _is_ponder_stopped = true;
+  thread::wait_for([&] { return !_is_ponder_running; });
+}
+
 // HumanPlayer class
 player::HumanPlayer::HumanPlayer(game::Game *g, piece::PieceColor c) : Player(g, c, PlayerType::HUMAN) {
   _r = -1;
@@ -141,308 +214,361 @@ void player::RandomPlayer::findAndPlayMove() {
 }
 
 // MinimaxPlayer class
-player::MinimaxPlayer::MinimaxPlayer(game::Game *g, piece::PieceColor c) : MinimaxPlayer(g, c, PlayerType::MINIMAX) {}
-player::MinimaxPlayer::MinimaxPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t) : Player(g, c, t) {
-  _search_depth = DEFAULT_SEARCH_DEPTH;
-  _simulation_board = nullptr;
-
-  _is_time_up = true;
-  _move_counter = 0;
-}
-player::MinimaxPlayer::~MinimaxPlayer() = default;
-
-int player::MinimaxPlayer::currentBoardScore() {
-  int score = 0;
-  piece::Piece *piece;
-  int r, c, temp;
-  for (r = 0; r < 8; ++r)
-    for (c = 0; c < 8; ++c) {
-      piece = _simulation_board->getPiece(r, c);
-      temp = piece->type().minimaxValue();
-      if (piece->color() == _color)
-        score += temp;
-      else
-        score -= temp;
-    }
-  return score;
+std::function<void(const player::SearchStatistics &, const std::vector<player::SearchLine> &)>
+  player::MinimaxPlayer::ON_ITERATION;
+
+player::MinimaxPlayer::MinimaxPlayer(game::Game *g, piece::PieceColor c) : MinimaxPlayer(g, c, PlayerType::MINIMAX,
+                                                                                         searchConfig()) {}
+player::MinimaxPlayer::MinimaxPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t,
+                                     const SearchConfig &config) : Player(g, c, t) {
+  _engine = new SearchEngine(config);
+  _is_pondering_enabled = false;
+  _statistics = new SearchStatistics();
+
+  _ponder_board = nullptr;
+  _ponder_result = nullptr;
 }
-
-std::vector<game::Move> player::MinimaxPlayer::allMoves(piece::PieceColor c) {
-  std::vector<game::Move> moves;
-
-  if (c.isWhite())
-    _simulation_board->getPossibleMoves(&moves, nullptr);
-  else if (c.isBlack())
-    _simulation_board->getPossibleMoves(nullptr, &moves);
-
-  return moves;
+player::MinimaxPlayer::~MinimaxPlayer() {
+  stopPondering();
+  delete _ponder_board;
+  delete _ponder_move;
+  delete _ponder_result;
+
+  delete _statistics;
+  delete _engine;
 }
 
-void player::MinimaxPlayer::timeKeeper(MinimaxPlayer *player, int moveCount, int time_in_seconds) {
-  thread::wait_for_timeout([&] { return player->moveOver(); }, time_in_seconds);
-  if (moveCount == player->_move_counter)
-    player->_is_time_up = true;
+player::SearchConfig player::MinimaxPlayer::searchConfig() {
+  SearchConfig config;
+  config.evaluator = SearchEngine::materialScore;
+  config.max_depth = DEFAULT_SEARCH_DEPTH;
+  config.alpha_beta = false;
+  config.move_ordering = false;
+  config.tablebases = false;
+  config.pawn_structure = false;
+  config.on_iteration = ON_ITERATION;
+  return config;
 }
 
 void player::MinimaxPlayer::findAndPlayMove() {
-  if (_search_depth <= 0) {
+  if (_engine->config().max_depth <= 0) {
     playRandomMove();
     return;
   }
 
-  thread::create(timeKeeper, this, _move_counter, 60); // set up 60 second thinking timer
-
-  playMove(bestMove());
-  ++_move_counter;
-  _is_time_up = true;
-}
+  _time_manager->startMove(*_search_limits);
+  game::Move move = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+  if (!finishPondering(&move))
+    move = _engine->search(_board, _color, *_search_limits, _time_manager, [this] { return moveOverByUndo(); });
+  _time_manager->endMove();
 
-game::Move player::MinimaxPlayer::bestMove() {
-  int depth = _search_depth;
-  _is_time_up = false;
+  *_statistics = _engine->lastSearchStatistics();
+  _principal_variation = _engine->principalVariation();
 
-  _simulation_board = _board->clone();
-  _simulation_board->set_pawn_upgrade_type(piece::PieceType::QUEEN);
-
-  std::vector<game::Move> moves = allMoves(_color);
-  std::set<std::pair<int, game::Move>, std::greater<>> moves_sortedByEndScore;
+  playMove(move);
+  if (_is_pondering_enabled)
+    startPondering();
+}
 
-  for (auto &move : moves) {
-    _simulation_board->doMove(new game::Move(move), nullptr);
-    int score = currentBoardScore();
-    _simulation_board->undoMove(nullptr);
+void player::MinimaxPlayer::startPondering() {
+  // only if our move was actually played && the game goes on
+  const std::vector<game::Move> &pv = _principal_variation;
+  if (pv.size() < 2 || _game->isOver() || _board->move_count() != _move_count_at_start + 1)
+    return;
 
-    moves_sortedByEndScore.insert(std::pair<int, game::Move>(score, move));
-  }
+  delete _ponder_board;
+  _ponder_board = _board->clone();
+  _ponder_board->doMove(pv[1], nullptr);
 
-  game::Move selectedMove = moves[0];
-  int maxScore = -500, newScore;
-  for (const auto &it : moves_sortedByEndScore) {
-    _simulation_board->doMove(new game::Move(it.second), nullptr);
+  std::vector<game::Move> moves;
+  if (_color.isWhite())
+    _ponder_board->getPossibleMoves(&moves, nullptr);
+  else
+    _ponder_board->getPossibleMoves(nullptr, &moves);
+  if (moves.empty()) // predicted reply ends the game -> nothing to search
+    return;
 
-    newScore = meanestResponse(depth - 1);
-    if (maxScore < newScore) {
-      maxScore = newScore;
-      selectedMove = it.second;
-    }
+  _ponder_move = new game::Move(pv[1]);
+  _ponder_move_count = _board->move_count() + 1;
+  _is_ponder_stopped = false;
+  _is_ponder_running = true;
+  _ponder_time_manager->startInfinite(); // here, not in ponder() -> a quick hit can't be overwritten by it
+  thread::create(ponder, this);
+}
 
-    _simulation_board->undoMove(nullptr);
+bool player::MinimaxPlayer::finishPondering(game::Move *move) {
+  if (_ponder_move == nullptr)
+    return false;
 
-    if (_is_time_up)
-      break;
+  // hit -> the ponder search is already on this position, it just needs to finish within this move's time
+  // (its clock takes over the budgets -> it stops at the soft limit between iterations, like any other search)
+  bool hit = isPonderHit();
+  if (hit) {
+    _ponder_time_manager->takeOver(*_time_manager);
+    thread::wait_for([&] { return !_is_ponder_running || _time_manager->hardLimitReached() || moveOverByUndo(); });
   }
+  stopPondering();
 
-  delete _simulation_board;
+  if (hit)
+    *move = *_ponder_result;
+  if (_engine->config().print_search_information)
+    std::cout << (hit ? "Ponder hit": "Ponder miss") << std::endl;
 
-  return selectedMove;
+  delete _ponder_move;
+  _ponder_move = nullptr;
+  return hit;
 }
 
-int player::MinimaxPlayer::bestMove(int depth) {
-  if (depth <= 0)
-    return currentBoardScore();
-
-  std::vector<game::Move> moves = allMoves(_color);
-  if (moves.empty())
-    return _simulation_board->isKingSafe(_color) ? 0: -1000; // If safe, stalemate; otherwise, opponent won
-
-  int maxScore = -500, newScore;
-  for (auto &move : moves) {
-    _simulation_board->doMove(new game::Move(move), nullptr);
+void player::MinimaxPlayer::ponder(MinimaxPlayer *player) {
+  game::Move move = player->_engine->search(player->_ponder_board, player->_color, *player->_search_limits,
+                                            player->_ponder_time_manager,
+                                            [player] { return (bool) player->_is_ponder_stopped; });
 
-    newScore = meanestResponse(depth - 1);
-    if (maxScore < newScore)
-      maxScore = newScore;
-
-    _simulation_board->undoMove(nullptr);
-
-    if (_is_time_up)
-      break;
-  }
-
-  return maxScore;
+  delete player->_ponder_result;
+  player->_ponder_result = new game::Move(move);
+  player->_is_ponder_running = false;
 }
 
-int player::MinimaxPlayer::meanestResponse(int depth) {
-  if (depth <= 0)
-    return currentBoardScore();
-
-  std::vector<game::Move> moves = allMoves(!_color);
-  if (moves.empty())
-    return _simulation_board->isKingSafe(!_color) ? 0: 1000; // If safe, stalemate; otherwise, we won
-
-  int minScore = 500, newScore;
-  for (auto &move : moves) {
-    _simulation_board->doMove(new game::Move(move), nullptr);
-
-    newScore = bestMove(depth - 1);
-    if (minScore > newScore)
-      minScore = newScore;
-
-    _simulation_board->undoMove(nullptr);
-
-    if (_is_time_up)
-      break;
-  }
-
-  return minScore;
+const player::SearchStatistics &player::MinimaxPlayer::lastSearchStatistics() const {
+  return *_statistics;
+}
+long player::MinimaxPlayer::lastSearchNodes() const {
+  return _statistics->nodes;
+}
+double player::MinimaxPlayer::lastSearchNPS() const {
+  return _statistics->nps();
+}
+const std::vector<game::Move> &player::MinimaxPlayer::principalVariation() const {
+  return _principal_variation;
 }
 
 // AlphaBetaPlayer Class
-player::AlphaBetaPlayer::AlphaBetaPlayer(game::Game *g, piece::PieceColor c) : player::MinimaxPlayer::MinimaxPlayer(g,
-                                                                                                                    c,
-                                                                                                                    player::PlayerType::AB_PRUNING) {
-  _search_depth = DEFAULT_SEARCH_DEPTH;
+int player::AlphaBetaPlayer::DEFAULT_NUM_THREADS = 1;
+bool player::AlphaBetaPlayer::PRINT_SEARCH_INFORMATION = false;
+bool player::AlphaBetaPlayer::USE_NULL_MOVE_PRUNING = true;
+bool player::AlphaBetaPlayer::USE_LATE_MOVE_REDUCTIONS = true;
+bool player::AlphaBetaPlayer::USE_FUTILITY_PRUNING = true;
+bool player::AlphaBetaPlayer::PONDERING = true;
+bool player::AlphaBetaPlayer::DETERMINISTIC = false;
+
+player::AlphaBetaPlayer::AlphaBetaPlayer(game::Game *g, piece::PieceColor c) : MinimaxPlayer(g, c,
+                                                                                             PlayerType::AB_PRUNING,
+                                                                                             searchConfig()) {
+  _is_pondering_enabled = PONDERING && !DETERMINISTIC;
 }
 player::AlphaBetaPlayer::~AlphaBetaPlayer() = default;
 
-int player::AlphaBetaPlayer::currentBoardScore() {
-  int score = 0;
-  piece::Piece *piece;
-
-  int r, c, temp;
-  for (r = 0; r < 8; ++r)
-    for (c = 0; c < 8; ++c) {
-      piece = _simulation_board->getPiece(r, c);
-      temp = piece->type().minimaxValue(r, c, piece->color());
-      if (piece->color() == _color)
-        score += temp;
-      else
-        score -= temp;
-    }
-
-  return score;
+player::SearchConfig player::AlphaBetaPlayer::searchConfig() {
+  SearchConfig config;
+  config.evaluator = SearchEngine::positionalScore;
+  config.max_depth = DEFAULT_SEARCH_DEPTH;
+  config.num_threads = DEFAULT_NUM_THREADS;
+  config.transposition_table_size_in_mb = TranspositionTable::DEFAULT_SIZE_IN_MB;
+  config.pawn_table_size_in_kb = PawnTable::DEFAULT_SIZE_IN_KB;
+  config.print_search_information = PRINT_SEARCH_INFORMATION;
+  config.null_move_pruning = USE_NULL_MOVE_PRUNING;
+  config.late_move_reductions = USE_LATE_MOVE_REDUCTIONS;
+  config.futility_pruning = USE_FUTILITY_PRUNING;
+  config.deterministic = DETERMINISTIC;
+  config.on_iteration = ON_ITERATION;
+  return config;
 }
 
-void player::AlphaBetaPlayer::findAndPlayMove() {
-  if (_search_depth <= 0) {
-    playRandomMove();
-    return;
-  }
+// NetworkAlphaBetaPlayer Class
+int player::NetworkAlphaBetaPlayer::NETWORK_BATCH_SIZE = 4;
 
-  thread::create(timeKeeper, this, _move_counter, 120); // set up 120 second thinking timer
+player::NetworkAlphaBetaPlayer::NetworkAlphaBetaPlayer(game::Game *g, piece::PieceColor c)
+  : MinimaxPlayer(g, c, PlayerType::AI_AB_PRUNING,
+                  searchConfig(network::NetworkStorage::current_network()->clone())) {
+  _network = _engine->config().network;
+  _is_pondering_enabled = AlphaBetaPlayer::PONDERING && !AlphaBetaPlayer::DETERMINISTIC;
+}
+player::NetworkAlphaBetaPlayer::~NetworkAlphaBetaPlayer() {
+  stopPondering(); // the ponder search still evaluates w/ _network
+  delete _network;
+}
 
-  playMove(bestMove());
-  ++_move_counter;
-  _is_time_up = true;
+player::SearchConfig player::NetworkAlphaBetaPlayer::searchConfig(network::Network *network) {
+  SearchConfig config = AlphaBetaPlayer::searchConfig();
+  config.network = network;
+  config.network_batch_size = NETWORK_BATCH_SIZE;
+  config.pawn_structure = false; // the network sees the pawns itself
+  config.max_depth = DEFAULT_SEARCH_DEPTH;
+  return config;
 }
 
-game::Move player::AlphaBetaPlayer::bestMove() {
-  int depth = _search_depth;
-  _is_time_up = false;
+// MonteCarloPlayer Class
+bool player::MonteCarloPlayer::PONDERING = true;
+long player::MonteCarloPlayer::MATE_SEARCH_NODES = 0;
+int player::MonteCarloPlayer::MATE_SEARCH_MOVES = 3;
 
-  _simulation_board = _board->clone();
-  _simulation_board->set_pawn_upgrade_type(piece::PieceType::QUEEN);
+player::MonteCarloPlayer::MonteCarloPlayer(game::Game *g, piece::PieceColor c) : MonteCarloPlayer(g, c,
+                                                                                                  player::PlayerType::MCTS) {
+  _move_ranker = new decider::Minimaxer();
+}
+player::MonteCarloPlayer::MonteCarloPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t) : Player(g, c,
+                                                                                                              t) {
+  _move_ranker = nullptr;
+  _mate_search = nullptr;
 
-  std::vector<game::Move> moves = allMoves(_color);
-  if (moves.size() == 1)
-    return moves[0];
+  _ponder_game = nullptr;
+  _ponder_result = nullptr;
+  _ponder_result_tree = nullptr;
+}
+player::MonteCarloPlayer::~MonteCarloPlayer() {
+  stopPondering();
+  deleteRoots();
+  delete _ponder_game;
+  delete _ponder_move;
+  delete _ponder_result;
+  delete _ponder_result_tree;
 
-  std::set<std::pair<int, game::Move>, std::greater<>> moves_sortedByEndScore;
+  delete _move_ranker;
+  delete _mate_search;
+}
 
-  for (auto &move : moves) {
-    _simulation_board->doMove(new game::Move(move), nullptr);
-    int score = currentBoardScore();
-    _simulation_board->undoMove(nullptr);
+void player::MonteCarloPlayer::findAndPlayMove() {
+  std::pair<game::Move, tree::Node *> move_node_pair{game::Move(-1, -1, -1, -1, piece::PieceType::NONE), nullptr};
+  _time_manager->startMove(*_search_limits);
+
+  // the endgame tables already know the result, or there is a forced mate -> no sampling (&& no use for the ponder
+  // search or its trees)
+  game::Move known_move = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+  if ((Tablebases::LOADED != nullptr && Tablebases::LOADED->bestMove(_board, _color, &known_move)) ||
+      findMate(&known_move)) {
+    stopPondering();
+    if (finishPondering(&move_node_pair))
+      delete move_node_pair.second;
+    deleteRoots();
+    _time_manager->endMove();
+    playMove(known_move);
+    return;
+  }
 
-    moves_sortedByEndScore.insert(std::pair<int, game::Move>(score, move));
+  if (!finishPondering(&move_node_pair)) {
+    deleteRoots();
+    for (int i = 0; i < std::max(tree::MCTS::DEFAULT_NUM_THREADS, 1); ++i)
+      _roots.push_back(new tree::Node(_game->getCurrentColor()));
+    move_node_pair = tree::MCTS::run_mcts_multithreaded(_game, (int) _roots.size(), _move_ranker, _roots,
+                                                        _search_limits, _time_manager);
   }
+  _time_manager->endMove();
 
-  game::Move selectedMove = moves[0];
-  int value = -10000, alpha = -10000, beta = 10000, newScore;
-  for (const auto &it : moves_sortedByEndScore) {
-    _simulation_board->doMove(new game::Move(it.second), nullptr);
-    newScore = alphaBetaSearch(depth - 1, alpha, beta, false);
-    if (value < newScore) {
-      value = newScore;
-      selectedMove = it.second;
-    }
-    _simulation_board->undoMove(nullptr);
+  playMove(move_node_pair.first);
+  delete move_node_pair.second; // free memory to prevent memory leaks
 
-    alpha = std::max(alpha, value);
-    if (_is_time_up || alpha >= beta)
-      break;
-  }
-  delete _simulation_board;
-  return selectedMove;
+  if (PONDERING && !tree::MCTS::DETERMINISTIC)
+    startPondering(move_node_pair.first);
+  else
+    deleteRoots();
 }
 
-int player::AlphaBetaPlayer::alphaBetaSearch(int depth, int alpha, int beta, bool maximizing) {
-  if (depth <= 0)
-    return currentBoardScore();
+bool player::MonteCarloPlayer::findMate(game::Move *move) {
+  if (MATE_SEARCH_NODES <= 0)
+    return false;
 
-  piece::PieceColor col = maximizing ? _color: !_color;
+  if (_mate_search == nullptr)
+    _mate_search = new MateSearch(MateSearch::DEFAULT_SIZE_IN_MB);
+  MateSearch::Result result = _mate_search->search(_board, _color, MATE_SEARCH_MOVES, MATE_SEARCH_NODES);
+  if (result.outcome != MateSearch::Result::MATE || result.line.empty())
+    return false;
 
-  std::vector<game::Move> moves = allMoves(col);
+  *move = result.line[0];
+  return true;
+}
 
-  if (moves.empty())
-    // If safe, stalemate; otherwise, checkmate -> if maxing, we lost; else, we won
-    return _simulation_board->isKingSafe(col) ? 0: (maximizing ? -100000: 100000);
+void player::MonteCarloPlayer::deleteRoots() {
+  for (auto &root : _roots)
+    delete root;
+  _roots.clear();
+}
 
-  if (maximizing) {
-    std::set<std::pair<int, game::Move>, std::greater<>> moves_sortedByEndScore;
+void player::MonteCarloPlayer::startPondering(const game::Move &played) {
+  // only if our move was actually played && the game goes on
+  if (_game->isOver() || _board->move_count() != _move_count_at_start + 1) {
+    deleteRoots();
+    return;
+  }
 
-    for (auto &move : moves) {
-      _simulation_board->doMove(new game::Move(move), nullptr);
-      int score = currentBoardScore();
-      _simulation_board->undoMove(nullptr);
+  // the subtree of our move from every thread -> the predicted reply is the one visited most over all of them
+  std::vector<tree::Node *> subtrees;
+  for (auto &root : _roots) {
+    tree::Node *subtree = root->detachChild(played);
+    subtrees.push_back(subtree != nullptr ? subtree: new tree::Node(!_color));
+  }
+  deleteRoots();
+
+  tree::Node *combined = tree::Node::combineNodes(subtrees, (int) subtrees.size());
+  bool has_reply = combined->countChildren() > 0;
+  game::Move reply = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+  if (has_reply)
+    reply = combined->selectOptimalMove([](tree::Node *, tree::Node *child) -> double {
+      return child->visit_count();
+    }).first;
+  delete combined;
+
+  // keep the subtrees of the reply as the roots of the ponder search
+  for (auto &subtree : subtrees) {
+    tree::Node *root = has_reply ? subtree->detachChild(reply): nullptr;
+    _roots.push_back(root != nullptr ? root: new tree::Node(_color));
+    delete subtree;
+  }
 
-      moves_sortedByEndScore.insert(std::pair<int, game::Move>(score, move));
-    }
+  if (!has_reply) {
+    deleteRoots();
+    return;
+  }
 
-    int value = -10000;
-    for (const auto &it : moves_sortedByEndScore) {
-      _simulation_board->doMove(new game::Move(it.second), nullptr);
-      value = std::max(value, alphaBetaSearch(depth - 1, alpha, beta, false));
-      _simulation_board->undoMove(nullptr);
+  delete _ponder_game;
+  _ponder_game = _game->clone();
+  _ponder_game->applyMove(reply);
+  if (_ponder_game->isOver()) { // predicted reply ends the game -> nothing to search
+    deleteRoots();
+    return;
+  }
 
-      alpha = std::max(alpha, value);
-      if (_is_time_up || alpha >= beta)
-        break;
-    }
-    return value;
-  } else {
-    std::set<std::pair<int, game::Move>, std::less<>> moves_sortedByEndScore;
+  _ponder_move = new game::Move(reply);
+  _ponder_move_count = _board->move_count() + 1;
+  _is_ponder_stopped = false;
+  _is_ponder_running = true;
+  thread::create(ponder, this);
+}
 
-    for (auto &move : moves) {
-      _simulation_board->doMove(new game::Move(move), nullptr);
-      int score = currentBoardScore();
-      _simulation_board->undoMove(nullptr);
+bool player::MonteCarloPlayer::finishPondering(std::pair<game::Move, tree::Node *> *result) {
+  if (_ponder_move == nullptr)
+    return false;
 
-      moves_sortedByEndScore.insert(std::pair<int, game::Move>(score, move));
-    }
+  // hit -> the ponder search ran on this exact position, so it only has to finish its simulations (or its time)
+  bool hit = isPonderHit();
+  if (hit)
+    thread::wait_for([&] { return !_is_ponder_running || _time_manager->optimumReached() || moveOverByUndo(); });
+  stopPondering();
 
-    int value = 10000;
-    for (const auto &it : moves_sortedByEndScore) {
-      _simulation_board->doMove(new game::Move(it.second), nullptr);
-      value = std::min(value, alphaBetaSearch(depth - 1, alpha, beta, true));
-      _simulation_board->undoMove(nullptr);
+  delete _ponder_move;
+  _ponder_move = nullptr;
 
-      beta = std::min(beta, value);
-      if (_is_time_up || beta <= alpha)
-        break;
-    }
-    return value;
+  if (hit) {
+    *result = {*_ponder_result, _ponder_result_tree};
+    _ponder_result_tree = nullptr;
+    return true;
   }
-}
 
-// MonteCarloPlayer Class
-player::MonteCarloPlayer::MonteCarloPlayer(game::Game *g, piece::PieceColor c) : Player(g, c,
-                                                                                        player::PlayerType::MCTS) {
-  _move_ranker = new decider::Minimaxer();
-}
-player::MonteCarloPlayer::MonteCarloPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t) : Player(g, c,
-                                                                                                              t) {
-  _move_ranker = nullptr;
-}
-player::MonteCarloPlayer::~MonteCarloPlayer() {
-  delete _move_ranker;
+  delete _ponder_result_tree;
+  _ponder_result_tree = nullptr;
+  deleteRoots();
+  return false;
 }
 
-void player::MonteCarloPlayer::findAndPlayMove() {
-  std::pair<game::Move, tree::Node *> move_node_pair = tree::MCTS::run_mcts_multithreaded(_game, _move_ranker);
+void player::MonteCarloPlayer::ponder(MonteCarloPlayer *player) {
+  player->_ponder_time_manager->startInfinite();
+  std::pair<game::Move, tree::Node *> move_node_pair = tree::MCTS::run_mcts_multithreaded(
+    player->_ponder_game, (int) player->_roots.size(), player->_move_ranker, player->_roots,
+    player->_search_limits, player->_ponder_time_manager, &player->_is_ponder_stopped);
 
-  playMove(move_node_pair.first);
-  delete move_node_pair.second; // free memory to prevent memory leaks
+  delete player->_ponder_result;
+  player->_ponder_result = new game::Move(move_node_pair.first);
+  player->_ponder_result_tree = move_node_pair.second;
+  player->_is_ponder_running = false;
 }
 
 // NetworkAIPlayer Class
@@ -453,7 +579,11 @@ player::NetworkAIPlayer::NetworkAIPlayer(game::Game *g, piece::PieceColor c) : M
 player::NetworkAIPlayer::~NetworkAIPlayer() = default; // _move_ranker is cleared by extended destructor from MCTS player
 
 void player::NetworkAIPlayer::findAndPlayMove() {
-  std::pair<game::Move, tree::Node *> move_node_pair = tree::MCTS::run_mcts_multithreaded(_game, _move_ranker);
+  _time_manager->startMove(*_search_limits);
+  std::pair<game::Move, tree::Node *> move_node_pair = tree::MCTS::run_mcts_multithreaded(_game, _move_ranker,
+                                                                                          _search_limits,
+                                                                                          _time_manager);
+  _time_manager->endMove();
 
   playMove(move_node_pair.first);
   network::NetworkStorage::saveBoard(_game->board(), move_node_pair.second);
@@ -38,13 +38,14 @@ class HumanPlayer;
 class RandomPlayer;
 class MinimaxPlayer;
 class AlphaBetaPlayer;
+class NetworkAlphaBetaPlayer;
 class MonteCarloPlayer;
 
 // Player Type "enum"
 class PlayerType {
   public:
     enum Type {
-      HUMAN, RANDOM, MINIMAX, AB_PRUNING, MCTS, AI
+      HUMAN, RANDOM, MINIMAX, AB_PRUNING, MCTS, AI, AI_AB_PRUNING
     };
 
     PlayerType() = default;
@@ -62,6 +63,7 @@ class PlayerType {
     constexpr bool isAlphaBetaPruningPlayer() const { return value == AB_PRUNING; }
     constexpr bool isMonteCarloTreeSearchPlayer() const { return value == MCTS; }
     constexpr bool isAIPlayer() const { return value == AI; }
+    constexpr bool isAIAlphaBetaPruningPlayer() const { return value == AI_AB_PRUNING; }
 
     inline Player *getPlayerOfType(game::Game *game, piece::PieceColor color) const {
       return getPlayerOfType(*this, game, color);
@@ -82,6 +84,8 @@ class PlayerType {
           return "Monte Carlo Tree Search Player";
         case AI:
           return "AI Network Player";
+        case AI_AB_PRUNING:
+          return "AI Network Alpha-Beta Pruning Player";
 
         default: FATAL_ASSERT
       }
@@ -28,10 +28,18 @@
 #include "player.fwd.h"
 
 #include <vector>
+#include <utility>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 
 #include "../mcts_network/decider.fwd.h"
 #include "../mcts_network/network.fwd.h"
 #include "../mcts_network/tree.fwd.h"
+#include "search.fwd.h"
+#include "time_manager.fwd.h"
+#include "opening_book.fwd.h"
+#include "mate_search.fwd.h"
 
 namespace player {
 
@@ -50,6 +58,14 @@ class Player {
     inline player::PlayerType type() { return _type; }
 
     void playNextMove(); // called by game when its this player's turn to move
+    void stop();         // ends the search of the current move as if its time was up -> the best move so far is played
+
+    // budget of every search of this player -> a new clock is started from limits.clock (call between moves)
+    void setSearchLimits(const SearchLimits &limits);
+    [[nodiscard]] const SearchLimits &searchLimits() const;
+
+    static OpeningBook *OPENING_BOOK; // consulted by the computer players before searching -> nullptr if no book
+    static SearchLimits DEFAULT_SEARCH_LIMITS; // limits of every new player
 
   protected:
     game::Game *_game;
@@ -59,8 +75,21 @@ class Player {
 
     int _move_count_at_start;
 
+    SearchLimits *_search_limits;
+    TimeManager *_time_manager; // game clock of this player -> from limits.clock (or TimeManager::DEFAULT_...)
+
     void playMove(const game::Move &m);
     void playRandomMove();
+    bool playBookMove(); // true iff a move was found in OPENING_BOOK (and played)
+
+    // pondering -> searching the reply we expect while the opponent thinks (see AlphaBetaPlayer, MonteCarloPlayer)
+    game::Move *_ponder_move; // predicted reply -> nullptr if not pondering
+    int _ponder_move_count;   // board move count once the predicted reply is played
+    std::atomic_bool _is_ponder_stopped, _is_ponder_running;
+    TimeManager *_ponder_time_manager; // started w/ startInfinite() -> pondering runs on its own clock until a hit
+
+    [[nodiscard]] bool isPonderHit() const; // the opponent played _ponder_move (nothing undone, search not stopped)
+    void stopPondering();                   // aborts the ponder search && waits for it to return
 
     virtual void findAndPlayMove() = 0;
     [[nodiscard]] bool moveOverByUndo() const;
@@ -105,24 +134,36 @@ class MinimaxPlayer : public Player {
     ~MinimaxPlayer() override;
     void findAndPlayMove() override;
 
-  protected:
-    game::Board *_simulation_board;
+    // stats of the search behind the last move played (see player::SearchEngine) -> not of the ponder search
+    [[nodiscard]] const SearchStatistics &lastSearchStatistics() const;
+    [[nodiscard]] long lastSearchNodes() const;
+    [[nodiscard]] double lastSearchNPS() const;
+    [[nodiscard]] const std::vector<game::Move> &principalVariation() const;
 
-    MinimaxPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t);
-    int _search_depth;
+    // SearchConfig::on_iteration of every minimax/alpha-beta player created from now on (ie uci info lines)
+    static std::function<void(const SearchStatistics &, const std::vector<SearchLine> &)> ON_ITERATION;
 
-    virtual int currentBoardScore();
-    std::vector<game::Move> allMoves(piece::PieceColor c);
+  protected:
+    MinimaxPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t, const SearchConfig &config);
 
-    bool _is_time_up;
-    int _move_counter;
+    SearchEngine *_engine;
+    bool _is_pondering_enabled;
 
-    static void timeKeeper(MinimaxPlayer *p, int moveCount, int time_in_seconds);
+    // copied from _engine after each move -> the engine's own are overwritten as soon as pondering starts
+    SearchStatistics *_statistics;
+    std::vector<game::Move> _principal_variation;
 
   private:
-    game::Move bestMove();
-    int bestMove(int depth);
-    int meanestResponse(int depth);
+    static SearchConfig searchConfig(); // plain minimax -> material only, no cutoffs
+
+    // pondering searches the position after the 2nd move of the principal variation on its own (unlimited) clock
+    // on a hit, that search gets this move's time to finish -> the table && iterations it already has are kept
+    game::Board *_ponder_board;
+    game::Move *_ponder_result;
+
+    void startPondering();
+    bool finishPondering(game::Move *move); // true on a ponder hit -> move is the ponder search's result
+    static void ponder(MinimaxPlayer *player);
 
     static const int DEFAULT_SEARCH_DEPTH = 4; // in half-moves -> each move by black OR white (white move followed by black move == 2 half-moves)
 };
@@ -133,24 +174,46 @@ class AlphaBetaPlayer : public MinimaxPlayer {
     AlphaBetaPlayer(const AlphaBetaPlayer &p) = delete;
     AlphaBetaPlayer &operator=(const AlphaBetaPlayer &p) = delete;
 
-    AlphaBetaPlayer(game::Game *g, piece::PieceColor c);;
+    AlphaBetaPlayer(game::Game *g, piece::PieceColor c);
     ~AlphaBetaPlayer() override;
-    void findAndPlayMove() override;
 
-  protected:
-    int currentBoardScore() override;
+    static int DEFAULT_NUM_THREADS; // 1 main thread + (n - 1) Lazy SMP helpers
+    static bool PRINT_SEARCH_INFORMATION;
 
-  private:
-    game::Move bestMove();
-    int alphaBetaSearch(int depth, int alpha, int beta, bool maximizing);
+    // selective search -> each can be switched off on its own (ie to compare strength w/ and w/o it)
+    static bool USE_NULL_MOVE_PRUNING;
+    static bool USE_LATE_MOVE_REDUCTIONS;
+    static bool USE_FUTILITY_PRUNING;
+
+    static bool PONDERING;
+    static bool DETERMINISTIC; // see SearchConfig::deterministic -> no pondering either (its timing decides the table)
 
-    static void timeKeeper(MinimaxPlayer *p, int moveCount, int time_in_seconds) {
-      MinimaxPlayer::timeKeeper(p, moveCount, time_in_seconds);
-    }
+    static SearchConfig searchConfig(); // every feature of the engine, positional evaluation (ie for analysis)
 
+  private:
     static const int DEFAULT_SEARCH_DEPTH = 6; // in half-moves -> each move by black OR white (white move followed by black move == 2 half-moves)
 };
 
+class NetworkAlphaBetaPlayer : public MinimaxPlayer {
+  public:
+    NetworkAlphaBetaPlayer() = delete;
+    NetworkAlphaBetaPlayer(const NetworkAlphaBetaPlayer &p) = delete;
+    NetworkAlphaBetaPlayer &operator=(const NetworkAlphaBetaPlayer &p) = delete;
+
+    NetworkAlphaBetaPlayer(game::Game *g, piece::PieceColor c);
+    ~NetworkAlphaBetaPlayer() override;
+
+    static int NETWORK_BATCH_SIZE; // leaves per forward pass (see SearchConfig::network_batch_size)
+
+    // AlphaBetaPlayer::searchConfig() w/ network as the evaluator (threads, pruning && pondering are shared w/ it)
+    static SearchConfig searchConfig(network::Network *network);
+
+  private:
+    network::Network *_network; // clone of the current network -> only read by the search threads
+
+    static const int DEFAULT_SEARCH_DEPTH = 4; // in half-moves -> each leaf costs a forward pass
+};
+
 class MonteCarloPlayer : public Player {
   public:
     MonteCarloPlayer() = delete;
@@ -161,9 +224,30 @@ class MonteCarloPlayer : public Player {
     ~MonteCarloPlayer() override;
     void findAndPlayMove() override;
 
+    static bool PONDERING; // never w/ tree::MCTS::DETERMINISTIC -> the trees kept would depend on the ponder time
+    // proof-number search for a forced mate before sampling (see MateSearch) -> 0 nodes = off
+    static long MATE_SEARCH_NODES;
+    static int MATE_SEARCH_MOVES; // longest mate looked for, in moves of this player
+
   protected:
     MonteCarloPlayer(game::Game *g, piece::PieceColor c, player::PlayerType t);
     decider::Decider *_move_ranker;
+
+  private:
+    MateSearch *_mate_search; // nullptr until the first mate search -> its table is kept from move to move
+
+    bool findMate(game::Move *move); // true iff a forced mate was proven w/in MATE_SEARCH_NODES -> move starts it
+    // search trees of the last search (one per thread) -> pondering keeps the subtree of the predicted reply
+    // on a hit, the ponder search already ran on the position w/ those trees, so its result is played directly
+    std::vector<tree::Node *> _roots;
+    game::Game *_ponder_game;
+    game::Move *_ponder_result;
+    tree::Node *_ponder_result_tree; // combined tree returned by the ponder search
+
+    void deleteRoots();
+    void startPondering(const game::Move &played);
+    bool finishPondering(std::pair<game::Move, tree::Node *> *result); // true on a ponder hit
+    static void ponder(MonteCarloPlayer *player);
 };
 
 class NetworkAIPlayer : public MonteCarloPlayer {
@@ -0,0 +1,974 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "search.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+#include "../chess/zobrist.h"
+#include "../mcts_network/network.h"
+#include "../util/thread_util.h"
+#include "transposition_table.h"
+#include "pawn_table.h"
+#include "time_manager.h"
+#include "tablebase.h"
+
+void player::SearchStatistics::reset() {
+  nodes = quiescence_nodes = 0;
+  tt_probes = tt_hits = 0;
+  beta_cutoffs = first_move_cutoffs = 0;
+  tablebase_hits = 0;
+  pawn_table_probes = pawn_table_hits = 0;
+  network_evaluations = network_batches = 0;
+  depth = selective_depth = 0;
+  elapsed = 0.0;
+  num_threads = 1;
+  iteration_nodes.clear();
+  iteration_times.clear();
+}
+
+void player::SearchStatistics::merge(const SearchStatistics &s) {
+  nodes += s.nodes;
+  quiescence_nodes += s.quiescence_nodes;
+  tt_probes += s.tt_probes;
+  tt_hits += s.tt_hits;
+  beta_cutoffs += s.beta_cutoffs;
+  first_move_cutoffs += s.first_move_cutoffs;
+  tablebase_hits += s.tablebase_hits;
+  pawn_table_probes += s.pawn_table_probes;
+  pawn_table_hits += s.pawn_table_hits;
+  network_evaluations += s.network_evaluations;
+  network_batches += s.network_batches;
+  selective_depth = std::max(selective_depth, s.selective_depth);
+}
+
+double player::SearchStatistics::branchingFactor() const {
+  std::size_t n = iteration_nodes.size();
+  if (n < 2 || iteration_nodes[n - 2] <= 0)
+    return 0.0;
+  return (double) iteration_nodes[n - 1] / iteration_nodes[n - 2];
+}
+
+std::string player::SearchStatistics::toString() const {
+  std::ostringstream output;
+  output << std::fixed << std::setprecision(1);
+  output << "Search: depth " << depth << "/" << selective_depth << ", " << nodes << " nodes (" << quiescence_nodes
+         << " quiescence), " << (long) nps() << " nps, " << num_threads << " thread(s), tt hits "
+         << 100.0 * ttHitRate() << "%, cutoffs " << beta_cutoffs << " (" << 100.0 * firstMoveCutoffRate()
+         << "% first move), pawn table hits " << 100.0 * pawnTableHitRate() << "%, tablebase hits " << tablebase_hits;
+  if (network_batches > 0)
+    output << ", network evaluations " << network_evaluations << " (" << network_batches << " batches)";
+  output << ", ebf " << std::setprecision(2) << branchingFactor() << ", " << (long) (1000 * elapsed) << " ms";
+  return output.str();
+}
+
+player::SearchEngine::SearchEngine(const SearchConfig &config) {
+  _config = config;
+  if (!_config.alpha_beta) { // all of these rely on cutoffs
+    _config.transposition_table = false;
+    _config.null_move_pruning = false;
+    _config.late_move_reductions = false;
+    _config.futility_pruning = false;
+    _config.principal_variation_search = false;
+    _config.aspiration_windows = false;
+  }
+  _config.num_threads = std::max(_config.num_threads, 1);
+  _config.network_batch_size = std::max(_config.network_batch_size, 1);
+  if (!_config.evaluator)
+    _config.evaluator = materialScore;
+
+  // deterministic -> every thread gets its share of the table size as a table of its own (the main thread's is _table)
+  bool split_table = _config.deterministic && _config.num_threads > 1;
+  int table_size_in_mb = split_table ? std::max(_config.transposition_table_size_in_mb / _config.num_threads, 1):
+                         _config.transposition_table_size_in_mb;
+  _table = _config.transposition_table ? new TranspositionTable(table_size_in_mb): nullptr;
+
+  for (int i = 0; i < _config.num_threads; ++i) {
+    auto *thread = new SearchThread();
+    thread->id = i;
+    thread->board = nullptr;
+    thread->table = _table != nullptr && split_table && i > 0 ? new TranspositionTable(table_size_in_mb): _table;
+    thread->pawn_table = _config.pawn_structure ? new PawnTable(_config.pawn_table_size_in_kb): nullptr;
+
+    for (auto &frame : thread->stack) {
+      frame.moves.reserve(MAX_MOVES);
+      frame.scores.reserve(MAX_MOVES);
+    }
+    thread->root_moves.reserve(MAX_MOVES);
+    if (_config.network != nullptr) {
+      thread->evaluation_keys.assign(EVALUATION_CACHE_SIZE, 0);
+      thread->evaluation_scores.assign(EVALUATION_CACHE_SIZE, 0);
+      thread->batch_keys.resize(_config.network_batch_size);
+      thread->network_inputs.resize(_config.network_batch_size * network::Network::INPUT_SIZE);
+    }
+
+    for (auto &killers : thread->killers)
+      killers[0] = killers[1] = 0;
+    for (auto &history : thread->history)
+      for (int &h : history)
+        h = 0;
+    thread->pv_length[0] = 0;
+    _threads.push_back(thread);
+  }
+
+  _time_manager = nullptr;
+  _is_aborted = nullptr;
+  _max_nodes = 0;
+  _is_time_up = true;
+
+  _statistics.iteration_nodes.reserve(MAX_PLY);
+  _statistics.iteration_times.reserve(MAX_PLY);
+  _principal_variation.reserve(MAX_PLY);
+}
+player::SearchEngine::~SearchEngine() {
+  for (auto &thread : _threads) {
+    if (thread->table != _table)
+      delete thread->table;
+    delete thread->pawn_table;
+    delete thread;
+  }
+  delete _table;
+}
+
+int player::SearchEngine::materialScore(game::Board *board, piece::PieceColor color) {
+  int score = 0;
+  board->forEachPiece([&](piece::Piece *piece, int, int) -> void {
+    int temp = piece->type().minimaxValue();
+    if (piece->color() == color)
+      score += temp;
+    else
+      score -= temp;
+  });
+  return score;
+}
+
+int player::SearchEngine::positionalScore(game::Board *board, piece::PieceColor color) {
+  int score = 0;
+  board->forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+    int temp = piece->type().minimaxValue(r, c, piece->color());
+    if (piece->color() == color)
+      score += temp;
+    else
+      score -= temp;
+  });
+  return score;
+}
+
+game::Move player::SearchEngine::search(game::Board *board, piece::PieceColor color, const SearchLimits &limits,
+                                        TimeManager *time_manager, const std::function<bool()> &is_aborted) {
+  // a position in the endgame tables needs no search at all
+  game::Move tablebase_move = game::Move(-1, -1, -1, -1, piece::PieceType::NONE);
+  Tablebases::Result tablebase_result{};
+  if (_config.tablebases && Tablebases::LOADED != nullptr &&
+      Tablebases::LOADED->bestMove(board, color, &tablebase_move, &tablebase_result)) {
+    _statistics.reset();
+    _statistics.tablebase_hits = 1;
+    _statistics.elapsed = time_manager->elapsed();
+    _principal_variation.assign(1, tablebase_move);
+    _lines.assign(1, SearchLine());
+    _lines[0].moves.assign(1, tablebase_move);
+    if (tablebase_result.outcome != Tablebases::DRAW)
+      _lines[0].score = (tablebase_result.outcome == Tablebases::WIN ? 1: -1) *
+                        (TABLEBASE_WIN_SCORE - tablebase_result.distance);
+    if (_config.print_search_information) {
+      Tablebases::Outcome outcome = tablebase_result.outcome;
+      std::cout << "Tablebase: " << (outcome == Tablebases::WIN ? "win": outcome == Tablebases::LOSS ? "loss": "draw")
+                << " in " << tablebase_result.distance << " plies, " << tablebase_move.toString() << std::endl;
+    }
+    return tablebase_move;
+  }
+
+  _root_color = color;
+  _time_manager = time_manager;
+  _is_aborted = &is_aborted;
+  _max_nodes = _config.deterministic ? 0: std::max(limits.nodes, 0L); // deterministic -> checked between iterations
+  _is_time_up = false;
+  if (_table != nullptr)
+    _table->newSearch();
+
+  // killers are position specific, history is only aged
+  for (auto &thread : _threads) {
+    if (thread->table != _table)
+      thread->table->newSearch();
+    thread->board = board->clone();
+    thread->board->set_pawn_upgrade_type(piece::PieceType::QUEEN);
+    thread->statistics.reset();
+    for (auto &killers : thread->killers)
+      killers[0] = killers[1] = 0;
+    for (auto &history : thread->history)
+      for (int &h : history)
+        h /= 8;
+  }
+  SearchThread &main = *_threads[0];
+  _statistics.reset();
+  _statistics.num_threads = _config.num_threads;
+
+  uint64_t key = main.board->hash() ^ zobrist::color_key(color);
+  TranspositionTable::Entry entry{};
+  uint16_t hash_move = _table != nullptr && _table->probe(key, 0, &entry) ? entry.move: 0;
+
+  generateMoves(main, 0, color);
+  if (_config.move_ordering) {
+    scoreMoves(main, 0, hash_move, color);
+    for (std::size_t i = 0; i < main.stack[0].moves.size(); ++i)
+      pickNextMove(main, 0, i);
+  }
+  std::vector<game::Move> &moves = main.root_moves;
+  moves = main.stack[0].moves;
+  for (auto &thread : _threads)
+    thread->root_moves = moves;
+
+  // no legal move -> the game is already over, the null move is returned && the score is its result
+  game::Move selectedMove = moves.empty() ? game::Move(-1, -1, -1, -1, piece::PieceType::NONE): moves[0];
+  _lines.assign(1, SearchLine());
+  if (moves.empty()) {
+    _principal_variation.clear();
+    _lines[0].score = main.board->isKingSafe(color) ? 0: -MATE_SCORE; // stalemate or checkmate
+  } else {
+    _principal_variation.assign(1, selectedMove);
+    _lines[0].moves.assign(1, selectedMove);
+  }
+  if (moves.size() > 1) {
+    // helpers only share what they find through the transposition table
+    // deterministic -> no helpers of this kind, the threads only ever work on the root moves splitRootSearch(...)
+    // hands them
+    bool split = _config.deterministic && _config.num_threads > 1;
+    _split_generation = _split_running = 0;
+    _is_split_over = false;
+    std::atomic_int helpers_finished{0};
+    for (int i = 1; i < _config.num_threads; ++i) {
+      if (split)
+        thread::create(splitWorker, this, _threads[i], std::ref(helpers_finished));
+      else
+        thread::create(helperSearch, this, _threads[i], std::ref(helpers_finished));
+    }
+
+    // iterative deepening -> selectedMove is always the result of the deepest completed iteration
+    // config.max_depth is only the default -> a search bounded by nodes or time goes as deep as it gets
+    int max_depth = _config.max_depth;
+    if (limits.depth > 0)
+      max_depth = std::min(limits.depth, MAX_PLY - 1);
+    else if (limits.nodes > 0 || (limits.hasTimeControl() && !_config.deterministic))
+      max_depth = MAX_PLY - 1;
+
+    // multi-pv -> line k is the best of the root moves the lines before it didn't take (moves[k...])
+    // the lines after the first mostly run into positions the first one already left in the transposition table
+    std::size_t num_lines = std::min((std::size_t) std::max(_config.multi_pv, 1), moves.size());
+    std::vector<SearchLine> lines(num_lines);
+    long previous_nodes = 0;
+    double previous_time = 0.0;
+    for (int depth = 1; depth <= max_depth; ++depth) {
+      for (std::size_t k = 0; k < num_lines; ++k) {
+        game::Move lineMove = moves[k];
+
+        // aspiration window around the line's last score -> widened (doubling) on whichever side the search fails
+        bool aspiration = _config.aspiration_windows && depth >= ASPIRATION_MIN_DEPTH;
+        int delta = ASPIRATION_WINDOW, value;
+        int alpha = aspiration ? std::max(lines[k].score - delta, -MATE_SCORE - 1): -MATE_SCORE - 1;
+        int beta = aspiration ? std::min(lines[k].score + delta, MATE_SCORE + 1): MATE_SCORE + 1;
+        while (true) {
+          value = split ? splitRootSearch(depth, alpha, beta, k, &lineMove):
+                  rootSearch(main, depth, alpha, beta, k, &lineMove);
+          if (_is_time_up)
+            break;
+
+          if (value <= alpha)
+            alpha = std::max(value - delta, -MATE_SCORE - 1);
+          else if (value >= beta)
+            beta = std::min(value + delta, MATE_SCORE + 1);
+          else
+            break;
+          delta *= 2;
+        }
+
+        if (_is_time_up)
+          break;
+
+        lines[k].score = value;
+        lines[k].depth = depth;
+        lines[k].moves.assign(1, lineMove);
+        for (int i = 1; i < main.pv_length[0]; ++i)
+          lines[k].moves.push_back(game::Move::unpack(main.pv[0][i]));
+
+        // the move belongs to line k now -> the lines after it search the rest
+        auto it = std::find(moves.begin() + (long) k, moves.end(), lineMove);
+        std::rotate(moves.begin() + (long) k, it, it + 1);
+      }
+
+      if (_is_time_up)
+        break;
+
+      // a later line can still come out ahead of an earlier one (ie through a deeper tt entry)
+      std::stable_sort(lines.begin(), lines.end(), [](const SearchLine &a, const SearchLine &b) {
+        return a.score > b.score;
+      });
+      for (std::size_t k = 0; k < num_lines; ++k)
+        moves[k] = lines[k].moves[0]; // best first in the next iteration
+      selectedMove = moves[0];
+      _lines = lines;
+      _principal_variation = lines[0].moves;
+
+      double time = _time_manager->elapsed();
+      long nodes = searchedNodes();
+      _statistics.depth = depth;
+      _statistics.iteration_nodes.push_back(nodes - previous_nodes);
+      _statistics.iteration_times.push_back(time - previous_time);
+      previous_nodes = nodes;
+      previous_time = time;
+      if (_table != nullptr)
+        _table->store(key, depth, 0, lines[0].score, TranspositionTable::EXACT, selectedMove.pack());
+
+      if (_config.print_search_information) {
+        for (std::size_t k = 0; k < num_lines; ++k) {
+          std::cout << "Search Depth " << depth;
+          if (num_lines > 1)
+            std::cout << " (line " << k + 1 << ")";
+          std::cout << ": score " << lines[k].score << ", " << _statistics.iteration_nodes.back() << " nodes, "
+                    << (long) (1000 * _statistics.iteration_times.back()) << " ms, pv";
+          for (const auto &move : lines[k].moves)
+            std::cout << " " << move.toString();
+          std::cout << std::endl;
+        }
+      }
+      if (_config.on_iteration) {
+        SearchStatistics progress = _statistics;
+        progress.nodes = nodes;
+        progress.selective_depth = main.statistics.selective_depth;
+        progress.elapsed = time;
+        _config.on_iteration(progress, lines);
+      }
+
+      if (_config.deterministic ? limits.nodes > 0 && nodes >= limits.nodes: _time_manager->softLimitReached())
+        break;
+    }
+
+    _is_time_up = true; // stops the helpers
+    {
+      std::lock_guard<std::mutex> lock(_split_mutex);
+      _is_split_over = true;
+    }
+    _split_started.notify_all();
+    thread::wait_for([&] { return helpers_finished >= _config.num_threads - 1; });
+  }
+
+  // helpers are done -> their counters can be read now
+  for (auto &thread : _threads) {
+    _statistics.merge(thread->statistics);
+    delete thread->board;
+    thread->board = nullptr;
+  }
+  _statistics.elapsed = _time_manager->elapsed();
+  if (_config.print_search_information)
+    std::cout << _statistics.toString() << std::endl;
+
+  _is_aborted = nullptr;
+  return selectedMove;
+}
+
+void player::SearchEngine::helperSearch(SearchEngine *engine, SearchThread *thread, std::atomic_int &finished_count) {
+  // odd helpers run one ply ahead of the even ones, so threads don't all finish the same depth together
+  std::vector<game::Move> &moves = thread->root_moves;
+  game::Move best = moves[0];
+  for (int depth = 1 + thread->id % 2; depth < MAX_PLY && !engine->_is_time_up; ++depth) {
+    engine->rootSearch(*thread, depth, -MATE_SCORE - 1, MATE_SCORE + 1, 0, &best);
+
+    auto it = std::find(moves.begin(), moves.end(), best);
+    std::rotate(moves.begin(), it, it + 1);
+  }
+
+  ++finished_count;
+}
+
+int player::SearchEngine::splitRootSearch(int depth, int alpha, int beta, std::size_t first, game::Move *best) {
+  SearchThread &main = *_threads[0];
+  const std::vector<game::Move> &moves = main.root_moves; // left alone by every thread until the split is over
+
+  // the eldest brother gets the full window, on the main thread
+  int value = rootSearch(main, depth, alpha, beta, first, best, first + 1);
+  if (_is_time_up || value >= beta || first + 1 >= moves.size())
+    return value;
+  int split_alpha = std::max(alpha, value);
+
+  // moves first + 1 + i go to thread i % num_threads (the main thread included)
+  _split_scores.assign(moves.size(), -MATE_SCORE - 1);
+  {
+    std::lock_guard<std::mutex> lock(_split_mutex);
+    _split_depth = depth;
+    _split_alpha = split_alpha;
+    _split_first = first;
+    _split_running = _config.num_threads - 1;
+    ++_split_generation;
+  }
+  _split_started.notify_all();
+  splitSearch(this, &main, depth, split_alpha, first);
+
+  // the abort flag is polled while the workers finish
+  std::unique_lock<std::mutex> lock(_split_mutex);
+  while (!_split_finished.wait_for(lock, std::chrono::milliseconds(1), [&] { return _split_running == 0; }))
+    if ((*_is_aborted)())
+      _is_time_up = true;
+  lock.unlock();
+  if (_is_time_up)
+    return value;
+
+  // a move that failed high can still be worse than a move before it -> searched again w/ the window so far
+  alpha = split_alpha;
+  for (std::size_t i = first + 1; i < moves.size(); ++i) {
+    int score = _split_scores[i];
+    if (score > split_alpha) {
+      main.board->doMove(moves[i], nullptr);
+      score = -search(main, depth - 1, 1, -beta, -alpha, !_root_color);
+      main.board->undoMove(nullptr);
+      if (_is_time_up)
+        break;
+    }
+
+    if (value < score) {
+      value = score;
+      *best = moves[i];
+    }
+    if (alpha < score) {
+      alpha = score;
+      updatePV(main, 0, moves[i]);
+    }
+    if (alpha >= beta)
+      break;
+  }
+  return value;
+}
+
+void player::SearchEngine::splitWorker(SearchEngine *engine, SearchThread *thread, std::atomic_int &finished_count) {
+  int generation = 0;
+  while (true) {
+    int depth, alpha;
+    std::size_t first;
+    {
+      std::unique_lock<std::mutex> lock(engine->_split_mutex);
+      engine->_split_started.wait(lock, [&] {
+        return engine->_is_split_over || engine->_split_generation != generation;
+      });
+      if (engine->_is_split_over)
+        break;
+      generation = engine->_split_generation;
+      depth = engine->_split_depth;
+      alpha = engine->_split_alpha;
+      first = engine->_split_first;
+    }
+
+    splitSearch(engine, thread, depth, alpha, first);
+
+    std::lock_guard<std::mutex> lock(engine->_split_mutex);
+    if (--engine->_split_running == 0)
+      engine->_split_finished.notify_one();
+  }
+
+  ++finished_count;
+}
+
+void player::SearchEngine::splitSearch(SearchEngine *engine, SearchThread *thread, int depth, int alpha,
+                                       std::size_t first) {
+  const std::vector<game::Move> &moves = engine->_threads[0]->root_moves;
+  for (std::size_t i = first + 1 + thread->id; i < moves.size() && !engine->_is_time_up;
+       i += engine->_config.num_threads) {
+    thread->board->doMove(moves[i], nullptr);
+    engine->_split_scores[i] = -engine->search(*thread, depth - 1, 1, -alpha - 1, -alpha, !engine->_root_color);
+    thread->board->undoMove(nullptr);
+  }
+}
+
+long player::SearchEngine::searchedNodes() const {
+  if (!_config.deterministic)
+    return _threads[0]->statistics.nodes;
+
+  long nodes = 0; // the threads are idle between splits
+  for (auto &thread : _threads)
+    nodes += thread->statistics.nodes;
+  return nodes;
+}
+
+int player::SearchEngine::rootSearch(SearchThread &thread, int depth, int alpha, int beta, std::size_t first,
+                                     game::Move *best, std::size_t last) {
+  thread.pv_length[0] = 0;
+
+  int value = -MATE_SCORE - 1, newScore;
+  for (std::size_t i = first; i < std::min(last, thread.root_moves.size()); ++i) {
+    const game::Move &move = thread.root_moves[i];
+    thread.board->doMove(move, nullptr);
+    if (i == first || !_config.principal_variation_search) {
+      newScore = -search(thread, depth - 1, 1, -beta, -alpha, !_root_color);
+    } else { // pvs -> prove the move is worse w/ a null window, only search it properly if that fails
+      newScore = -search(thread, depth - 1, 1, -alpha - 1, -alpha, !_root_color);
+      if (alpha < newScore && newScore < beta && !_is_time_up)
+        newScore = -search(thread, depth - 1, 1, -beta, -alpha, !_root_color);
+    }
+    thread.board->undoMove(nullptr);
+
+    if (_is_time_up)
+      break;
+
+    if (value < newScore) {
+      value = newScore;
+      *best = move;
+    }
+    if (alpha < newScore) {
+      alpha = newScore;
+      updatePV(thread, 0, move);
+    }
+    if (alpha >= beta)
+      break;
+  }
+  return value;
+}
+
+int player::SearchEngine::search(SearchThread &thread, int depth, int ply, int alpha, int beta,
+                                 piece::PieceColor color, bool allow_null_move) {
+  // exact results -> checked before the horizon, so leaves are resolved too
+  int tablebase_score;
+  if (_config.tablebases && probeTablebases(thread, ply, color, &tablebase_score))
+    return tablebase_score;
+
+  if (depth <= 0 || ply >= MAX_PLY) {
+    if (_config.quiescence)
+      return quiescenceSearch(thread, ply, alpha, beta, color);
+    countNode(thread);
+    if (ply < MAX_PLY)
+      thread.pv_length[ply] = ply;
+    return evaluate(thread, color);
+  }
+  countNode(thread);
+  thread.statistics.selective_depth = std::max(thread.statistics.selective_depth, ply);
+  thread.pv_length[ply] = ply;
+
+  // plain minimax -> every node gets the full window, so nothing is ever cut
+  if (!_config.alpha_beta) {
+    alpha = -MATE_SCORE - 1;
+    beta = MATE_SCORE + 1;
+  }
+
+  // a stored result at least this deep can narrow the window (or settle the position outright)
+  // pv nodes (open window) are always searched -> cutting them would truncate the principal variation
+  int alpha_original = alpha;
+  bool pv_node = beta - alpha > 1;
+  uint64_t key = thread.board->hash() ^ zobrist::color_key(color);
+  TranspositionTable::Entry entry{};
+  uint16_t hash_move = 0;
+  thread.statistics.tt_probes += thread.table != nullptr;
+  if (thread.table != nullptr && thread.table->probe(key, ply, &entry)) {
+    ++thread.statistics.tt_hits;
+    hash_move = entry.move;
+    if (entry.depth >= depth && !pv_node) {
+      switch (entry.bound()) {
+        case TranspositionTable::EXACT:
+          return entry.score;
+        case TranspositionTable::LOWER:
+          alpha = std::max(alpha, entry.score);
+          break;
+        case TranspositionTable::UPPER:
+          beta = std::min(beta, entry.score);
+          break;
+        default:
+          break;
+      }
+      if (alpha >= beta)
+        return entry.score;
+    }
+  }
+
+  bool in_check = !thread.board->isKingSafe(color);
+  int static_score = _config.null_move_pruning || _config.futility_pruning ? evaluate(thread, color): 0;
+
+  // null move -> if passing still fails high, a real move will too
+  // not in check, not twice in a row, and only w/ pieces left (pawn/king endings are where zugzwang lives)
+  if (_config.null_move_pruning && allow_null_move && !in_check && depth >= NULL_MOVE_MIN_DEPTH &&
+      static_score >= beta && beta < MATE_BOUND && hasNonPawnMaterial(thread.board, color)) {
+    int reduction = NULL_MOVE_REDUCTION + (depth > 6);
+    int score = -search(thread, depth - 1 - reduction, ply + 1, -beta, -beta + 1, !color, false);
+    if (_is_time_up)
+      return score;
+    if (score >= beta)
+      return score >= MATE_BOUND ? beta: score; // don't trust mates found after passing
+  }
+
+  Frame &frame = thread.stack[ply];
+  generateMoves(thread, ply, color);
+
+  if (frame.moves.empty())
+    // If safe, stalemate; otherwise, checkmate -> player to move lost (the sooner, the worse)
+    return in_check ? -MATE_SCORE + ply: 0;
+
+  if (_config.move_ordering)
+    scoreMoves(thread, ply, hash_move, color);
+
+  // futility -> at frontier nodes, a quiet move that can't lift the static score near alpha isn't worth searching
+  bool futile = _config.futility_pruning && depth == 1 && !in_check && static_score + FUTILITY_MARGIN <= alpha &&
+                alpha > -MATE_BOUND;
+
+  int value = -MATE_SCORE - 1;
+  uint16_t best_move = 0;
+  for (std::size_t i = 0; i < frame.moves.size(); ++i) {
+    if (_config.move_ordering)
+      pickNextMove(thread, ply, i);
+    const game::Move &move = frame.moves[i];
+    bool quiet = isQuiet(thread.board, move);
+
+    if (futile && quiet && i > 0) {
+      value = std::max(value, static_score + FUTILITY_MARGIN);
+      continue;
+    }
+
+    if (i > 0 && depth == 1) // frontier -> every child is evaluated first thing (stand pat)
+      evaluateChildren(thread, ply, i, [&](const game::Move &m) { return !futile || !isQuiet(thread.board, m); });
+    thread.board->doMove(move, nullptr);
+
+    // late move reductions -> moves ordered this late rarely raise alpha, so check that at a lower depth first
+    int reduction = 0;
+    if (_config.late_move_reductions && i > 0 && quiet && !in_check && depth >= LMR_MIN_DEPTH &&
+        i >= LMR_MIN_MOVE_INDEX && thread.board->isKingSafe(!color))
+      reduction = 1 + (depth >= 6 && i >= 2 * LMR_MIN_MOVE_INDEX);
+
+    int score;
+    if (i == 0 || (!_config.principal_variation_search && reduction == 0)) {
+      score = -search(thread, depth - 1, ply + 1, -beta, -alpha, !color);
+    } else {
+      // pvs -> every move after the first is expected to fail low, a null window is enough to prove it
+      score = -search(thread, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, !color);
+      if (alpha < score && reduction > 0 && !_is_time_up)
+        score = -search(thread, depth - 1, ply + 1, -alpha - 1, -alpha, !color);
+      if (alpha < score && score < beta && !_is_time_up)
+        score = -search(thread, depth - 1, ply + 1, -beta, -alpha, !color);
+    }
+    thread.board->undoMove(nullptr);
+
+    if (value < score) {
+      value = score;
+      best_move = move.pack();
+    }
+
+    if (alpha < value) {
+      alpha = value;
+      updatePV(thread, ply, move);
+    }
+    if (_is_time_up)
+      break;
+    if (alpha >= beta) {
+      ++thread.statistics.beta_cutoffs;
+      thread.statistics.first_move_cutoffs += i == 0;
+      if (quiet && _config.move_ordering)
+        updateQuietCutoff(thread, move, depth, ply, color);
+      break;
+    }
+  }
+
+  // results cut short by the timer are incomplete -> never store them
+  if (thread.table != nullptr && !_is_time_up) {
+    TranspositionTable::Bound bound = value <= alpha_original ? TranspositionTable::UPPER:
+                                      value >= beta ? TranspositionTable::LOWER: TranspositionTable::EXACT;
+    thread.table->store(key, depth, ply, value, bound, best_move);
+  }
+  return value;
+}
+
+int player::SearchEngine::quiescenceSearch(SearchThread &thread, int ply, int alpha, int beta,
+                                           piece::PieceColor color) {
+  countNode(thread);
+  ++thread.statistics.quiescence_nodes;
+  thread.statistics.selective_depth = std::max(thread.statistics.selective_depth, ply);
+  if (ply < MAX_PLY)
+    thread.pv_length[ply] = ply; // the pv ends where quiescence starts
+
+  // plain minimax -> full window like search(), && no delta pruning (it cuts against alpha too)
+  // every capture sequence w/o cutoffs is far too many nodes though -> only recaptures on the last move's square
+  int recapture_square = -1;
+  if (!_config.alpha_beta) {
+    alpha = -MATE_SCORE - 1;
+    beta = MATE_SCORE + 1;
+
+    const game::Move *last_move = thread.board->peekLastMove();
+    if (last_move != nullptr)
+      recapture_square = last_move->endingRow() * 8 + last_move->endingColumn();
+  }
+  auto is_skipped_capture = [&](const game::Move &m) -> bool {
+    return recapture_square >= 0 && m.endingRow() * 8 + m.endingColumn() != recapture_square;
+  };
+
+  // stand pat -> the player to move can (usually) decline every capture, so the static score is a lower bound
+  // not an option in check though, every evasion gets searched instead
+  // both cutoffs come before move generation, which is by far the most expensive part of a node
+  bool in_check = !thread.board->isKingSafe(color);
+  int stand_pat = evaluate(thread, color);
+  bool delta_pruning = _config.alpha_beta && !in_check;
+  if (ply >= MAX_PLY || (!in_check && stand_pat >= beta) ||
+      (delta_pruning && stand_pat + QUEEN_PROMOTION_GAIN + DELTA_MARGIN <= alpha))
+    return stand_pat;
+
+  Frame &frame = thread.stack[ply];
+  generateMoves(thread, ply, color);
+  if (frame.moves.empty())
+    return in_check ? -MATE_SCORE + ply: 0; // If safe, stalemate; otherwise, checkmate -> player to move lost
+
+  int value = in_check ? -MATE_SCORE - 1: stand_pat;
+  alpha = std::max(alpha, value);
+
+  if (_config.move_ordering)
+    scoreMoves(thread, ply, 0, color);
+  for (std::size_t i = 0; i < frame.moves.size(); ++i) {
+    if (_config.move_ordering)
+      pickNextMove(thread, ply, i);
+    const game::Move &move = frame.moves[i];
+    if (!in_check && isQuiet(thread.board, move)) {
+      if (_config.move_ordering)
+        break; // captures/promotions are ordered first -> only quiet moves left
+      continue;
+    }
+    if (!in_check && is_skipped_capture(move))
+      continue;
+    if (delta_pruning && stand_pat + captureGain(thread.board, move) + DELTA_MARGIN <= alpha)
+      continue; // delta pruning -> even winning the piece for free can't raise alpha
+
+    if (i > 0)
+      evaluateChildren(thread, ply, i, [&](const game::Move &m) {
+        return in_check || (!isQuiet(thread.board, m) && !is_skipped_capture(m) &&
+                            (!delta_pruning || stand_pat + captureGain(thread.board, m) + DELTA_MARGIN > alpha));
+      });
+    thread.board->doMove(move, nullptr);
+    int score = -quiescenceSearch(thread, ply + 1, -beta, -alpha, !color);
+    thread.board->undoMove(nullptr);
+
+    value = std::max(value, score);
+    alpha = std::max(alpha, value);
+    if (alpha >= beta || _is_time_up)
+      break;
+  }
+
+  return value;
+}
+
+int player::SearchEngine::evaluate(SearchThread &thread, piece::PieceColor color) {
+  int score = _config.network != nullptr ? networkScore(thread, color): _config.evaluator(thread.board, color);
+  if (thread.pawn_table == nullptr)
+    return score;
+
+  bool hit;
+  score += thread.pawn_table->score(thread.board, color, &hit);
+  ++thread.statistics.pawn_table_probes;
+  thread.statistics.pawn_table_hits += hit;
+  return score;
+}
+
+int player::SearchEngine::networkScore(SearchThread &thread, piece::PieceColor color) {
+  // the network only sees the pieces -> the board hash (w/o side to move) is the whole key
+  uint64_t key = thread.board->hash();
+  std::size_t index = key & (EVALUATION_CACHE_SIZE - 1U);
+  if (thread.evaluation_keys[index] != key) { // not sent ahead of time -> a batch of its own
+    network::Network::encodeBoard(thread.board, thread.network_inputs.data());
+    _config.network->predictPositions(thread.network_inputs, 1, &thread.network_outputs, &thread.network_scratch);
+    ++thread.statistics.network_batches;
+    storeEvaluation(thread, key, thread.network_outputs[0]);
+  }
+
+  int score = thread.evaluation_scores[index];
+  return color.isWhite() ? score: -score;
+}
+
+// the first move of a node is left to evaluate itself -> most cutoffs come from it, which would waste the batch
+// once it didn't cut, the node probably searches all of its moves, so the next few get evaluated together
+void player::SearchEngine::evaluateChildren(SearchThread &thread, int ply, std::size_t first,
+                                            const std::function<bool(const game::Move &)> &is_searched) {
+  Frame &frame = thread.stack[ply];
+  if (_config.network == nullptr || _config.network_batch_size <= 1 || first < frame.evaluated)
+    return;
+
+  int count = 0;
+  std::size_t i = first;
+  for (; i < frame.moves.size() && count < _config.network_batch_size; ++i) {
+    // the same selection sort steps the search loop takes -> moves[i] is the i-th move searched (scores don't change)
+    if (_config.move_ordering)
+      pickNextMove(thread, ply, i);
+    const game::Move &move = frame.moves[i];
+    if (!is_searched(move)) {
+      if (_config.move_ordering)
+        break; // ordered -> the moves after it are pruned too (quiet or smaller captures)
+      continue;
+    }
+
+    thread.board->doMove(move, nullptr);
+    uint64_t key = thread.board->hash();
+    if (thread.evaluation_keys[key & (EVALUATION_CACHE_SIZE - 1U)] != key) {
+      network::Network::encodeBoard(thread.board, thread.network_inputs.data() + count * network::Network::INPUT_SIZE);
+      thread.batch_keys[count++] = key;
+    }
+    thread.board->undoMove(nullptr);
+  }
+  frame.evaluated = i;
+
+  if (count == 0)
+    return;
+  _config.network->predictPositions(thread.network_inputs, count, &thread.network_outputs, &thread.network_scratch);
+  ++thread.statistics.network_batches;
+  for (int k = 0; k < count; ++k)
+    storeEvaluation(thread, thread.batch_keys[k], thread.network_outputs[k]);
+}
+
+void player::SearchEngine::storeEvaluation(SearchThread &thread, uint64_t key, double output) {
+  std::size_t index = key & (EVALUATION_CACHE_SIZE - 1U);
+  thread.evaluation_keys[index] = key;
+  thread.evaluation_scores[index] = (int) std::lround(output * _config.network_scale);
+  ++thread.statistics.network_evaluations;
+}
+
+void player::SearchEngine::setMultiPV(int num_lines) {
+  _config.multi_pv = std::max(num_lines, 1);
+}
+
+void player::SearchEngine::countNode(SearchThread &thread) {
+  // only the main thread watches the clock (&& the node limit)
+  ++thread.statistics.nodes;
+  if (thread.id != 0)
+    return;
+  if (_max_nodes > 0 && thread.statistics.nodes >= _max_nodes)
+    _is_time_up = true;
+  else if (thread.statistics.nodes % CLOCK_CHECK_INTERVAL == 0 &&
+           ((!_config.deterministic && _time_manager->hardLimitReached()) || (*_is_aborted)()))
+    _is_time_up = true;
+}
+
+void player::SearchEngine::generateMoves(SearchThread &thread, int ply, piece::PieceColor color) {
+  std::vector<game::Move> &moves = thread.stack[ply].moves;
+  moves.clear(); // keeps its capacity -> no allocation once the stack is warm
+  thread.stack[ply].evaluated = 0;
+
+  if (color.isWhite())
+    thread.board->getPossibleMoves(&moves, nullptr);
+  else if (color.isBlack())
+    thread.board->getPossibleMoves(nullptr, &moves);
+}
+
+bool player::SearchEngine::isQuiet(game::Board *board, const game::Move &move) {
+  return move.pawn_promotion_type().isEmpty() && !move.isAttack(board);
+}
+
+int player::SearchEngine::captureGain(game::Board *board, const game::Move &move) {
+  piece::PieceType victim = board->getPiece(move.endingRow(), move.endingColumn())->type();
+  int gain = victim.isEmpty() && move.isAttack(board) ? 1: victim.minimaxValue(); // empty target -> en passant
+  if (!move.pawn_promotion_type().isEmpty())
+    gain += move.pawn_promotion_type().minimaxValue() - 1;
+  return gain;
+}
+
+bool player::SearchEngine::hasNonPawnMaterial(game::Board *board, piece::PieceColor color) {
+  bool found = false;
+  board->forEachPiece(color, [&](piece::Piece *piece, int, int) -> void {
+    found |= !piece->type().isPawn() && !piece->type().isKing();
+  });
+  return found;
+}
+
+bool player::SearchEngine::probeTablebases(SearchThread &thread, int ply, piece::PieceColor color, int *score) {
+  const Tablebases *tables = Tablebases::LOADED;
+  if (tables == nullptr || thread.board->pieceCount(piece::PieceColor::NONE) > tables->maxPieces())
+    return false;
+
+  Tablebases::Result result{};
+  if (!tables->probe(thread.board, color, &result))
+    return false;
+
+  countNode(thread);
+  ++thread.statistics.tablebase_hits;
+  if (ply < MAX_PLY)
+    thread.pv_length[ply] = ply;
+
+  // sooner mates score higher (from the root's view) -> the search heads for the fastest win
+  int win_score = TABLEBASE_WIN_SCORE - ply - result.distance;
+  *score = result.outcome == Tablebases::WIN ? win_score: result.outcome == Tablebases::LOSS ? -win_score: 0;
+  return true;
+}
+
+void player::SearchEngine::scoreMoves(SearchThread &thread, int ply, uint16_t hash_move, piece::PieceColor color) {
+  const int HASH_MOVE = 1 << 30, CAPTURE = 1 << 20, KILLER = 1 << 19;
+  const std::vector<game::Move> &moves = thread.stack[ply].moves;
+  std::vector<int> &scores = thread.stack[ply].scores;
+
+  scores.resize(moves.size());
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    const game::Move &move = moves[i];
+    uint16_t packed = move.pack();
+    piece::PieceType attacker = thread.board->getPiece(move.startingRow(), move.startingColumn())->type();
+    piece::PieceType victim = thread.board->getPiece(move.endingRow(), move.endingColumn())->type();
+
+    if (packed == hash_move)
+      scores[i] = HASH_MOVE;
+    else if (!isQuiet(thread.board, move)) // most valuable victim first, then least valuable attacker (en passant takes a pawn)
+      scores[i] = CAPTURE + 128 * (victim.isEmpty() && attacker.isPawn() && move.startingColumn() != move.endingColumn() ?
+                                   1: victim.minimaxValue()) - attacker.minimaxValue() +
+                  16 * move.pawn_promotion_type().minimaxValue();
+    else if (packed == thread.killers[ply][0])
+      scores[i] = KILLER + 1;
+    else if (packed == thread.killers[ply][1])
+      scores[i] = KILLER;
+    else // history, w/ the positional gain of the move (see positionalScore(...)) breaking ties
+      scores[i] = std::min(thread.history[color][packed & 4095U] +
+                           attacker.minimaxValue(move.endingRow(), move.endingColumn(), color) -
+                           attacker.minimaxValue(move.startingRow(), move.startingColumn(), color), KILLER - 1);
+  }
+}
+
+// selection sort step -> only the moves actually searched before a cutoff get sorted
+void player::SearchEngine::pickNextMove(SearchThread &thread, int ply, std::size_t index) {
+  std::vector<game::Move> &moves = thread.stack[ply].moves;
+  std::vector<int> &scores = thread.stack[ply].scores;
+
+  std::size_t best = index;
+  for (std::size_t i = index + 1; i < moves.size(); ++i)
+    if (scores[i] > scores[best])
+      best = i;
+
+  if (best != index) {
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+  }
+}
+
+void player::SearchEngine::updatePV(SearchThread &thread, int ply, const game::Move &move) {
+  thread.pv[ply][ply] = move.pack();
+  int length = ply + 1 < MAX_PLY ? thread.pv_length[ply + 1]: ply + 1;
+  for (int i = ply + 1; i < length; ++i)
+    thread.pv[ply][i] = thread.pv[ply + 1][i];
+  thread.pv_length[ply] = std::max(length, ply + 1);
+}
+
+void player::SearchEngine::updateQuietCutoff(SearchThread &thread, const game::Move &move, int depth, int ply,
+                                             piece::PieceColor color) {
+  uint16_t packed = move.pack();
+  uint16_t *killers = thread.killers[ply];
+  if (killers[0] != packed) {
+    killers[1] = killers[0];
+    killers[0] = packed;
+  }
+
+  thread.history[color][packed & 4095U] += depth * depth;
+}
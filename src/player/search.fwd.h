@@ -0,0 +1,43 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_SEARCH_FWD_H_
+#define CHESS_AI_PLAYER_SEARCH_FWD_H_
+
+namespace player {
+
+// Counters of one search (nodes, cutoffs, tt hits, time per iteration...) -> see SearchEngine::lastSearchStatistics()
+class SearchStatistics;
+// Which features a SearchEngine uses (evaluator, pruning on/off, depth && threads)
+class SearchConfig;
+// One ranked root move of a (multi-pv) search w/ its score && principal variation
+class SearchLine;
+// Budget of one search (nodes, depth, time) -> every player's search stops at whichever limit it hits first
+class SearchLimits;
+// Negamax search shared by all minimax style players -> one preallocated search stack per thread
+class SearchEngine;
+
+}
+
+#endif // CHESS_AI_PLAYER_SEARCH_FWD_H_
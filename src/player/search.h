@@ -0,0 +1,311 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_SEARCH_H_
+#define CHESS_AI_PLAYER_SEARCH_H_
+
+#include "search.fwd.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+
+#include "../chess/piece.h"
+#include "../chess/game.h"
+#include "../mcts_network/network.fwd.h"
+#include "transposition_table.fwd.h"
+#include "pawn_table.fwd.h"
+#include "time_manager.fwd.h"
+
+namespace player {
+
+// The SearchStatistics class: See search.fwd.h
+// Plain counters -> each thread counts into its own copy, merged by the main thread once the search is over
+class SearchStatistics {
+  public:
+    long nodes = 0; // every node visited, quiescence included
+    long quiescence_nodes = 0;
+    long tt_probes = 0, tt_hits = 0;
+    long beta_cutoffs = 0, first_move_cutoffs = 0; // cutoffs by the first move searched -> move ordering quality
+    long tablebase_hits = 0; // positions resolved by the endgame tables (root included)
+    long pawn_table_probes = 0, pawn_table_hits = 0; // every evaluation w/ pawn structure probes the pawn table
+    long network_evaluations = 0, network_batches = 0; // positions sent through SearchConfig::network && forward passes
+    int depth = 0;           // deepest completed iteration
+    int selective_depth = 0; // deepest ply reached, quiescence included
+    double elapsed = 0.0;    // in seconds
+    int num_threads = 1;
+
+    // main thread only -> one entry per completed iteration
+    std::vector<long> iteration_nodes;
+    std::vector<double> iteration_times; // in seconds
+
+    void reset();
+    void merge(const SearchStatistics &s); // adds the counters of another thread
+
+    [[nodiscard]] inline double nps() const { return elapsed > 0.0 ? nodes / elapsed: 0.0; }
+    [[nodiscard]] inline double ttHitRate() const { return tt_probes > 0 ? (double) tt_hits / tt_probes: 0.0; }
+    [[nodiscard]] inline double pawnTableHitRate() const {
+      return pawn_table_probes > 0 ? (double) pawn_table_hits / pawn_table_probes: 0.0;
+    }
+    [[nodiscard]] inline double firstMoveCutoffRate() const {
+      return beta_cutoffs > 0 ? (double) first_move_cutoffs / beta_cutoffs: 0.0;
+    }
+    [[nodiscard]] double branchingFactor() const; // nodes of the last iteration / nodes of the one before
+
+    [[nodiscard]] std::string toString() const; // one line, for logs
+};
+
+// The SearchConfig class: See search.fwd.h
+// Features that only make sense w/ cutoffs (everything from transposition_table on) are ignored if !alpha_beta
+class SearchConfig {
+  public:
+    // static score of the board from the view of the given color (see SearchEngine::materialScore(...))
+    std::function<int(game::Board *, piece::PieceColor)> evaluator;
+    // replaces evaluator if set (not owned, only read -> shared by all threads) -> scores are the network's output
+    // times network_scale, && the children of a node are evaluated network_batch_size at a time (one forward pass)
+    network::Network *network = nullptr;
+    int network_batch_size = 4; // 1 = no batches
+    int network_scale = 4; // in pawns per unit of network output (which is within +-4)
+
+    int max_depth = 4; // in half-moves -> iterative deepening stops here even if there is time left
+    int num_threads = 1; // 1 main thread + (n - 1) Lazy SMP helpers
+    int transposition_table_size_in_mb = 32;
+    bool print_search_information = false;
+
+    bool alpha_beta = true; // false -> plain minimax, every move gets searched w/ the full window
+    bool quiescence = true;
+    bool transposition_table = true;
+    bool move_ordering = true; // hash move, MVV-LVA, killers, history
+    bool null_move_pruning = true;
+    bool late_move_reductions = true;
+    bool futility_pruning = true;
+    bool principal_variation_search = true;
+    bool aspiration_windows = true;
+    bool tablebases = true; // probe Tablebases::LOADED at the root && at every node (if any tables are loaded)
+    bool pawn_structure = true; // evaluator + doubled/isolated/passed pawn terms, cached in a PawnTable per thread
+    int pawn_table_size_in_kb = 256;
+
+    int multi_pv = 1; // root moves searched as lines of their own (see SearchEngine::lastSearchLines())
+
+    // same position, limits && history of searches -> same move, score && node count, whatever the thread timing
+    // the threads split the root moves between them (instead of Lazy SMP), each w/ a table of its own, && only the
+    // depth/node limits (or an abort) stop the search -> the clock is ignored
+    bool deterministic = false;
+
+    // called by the main thread after every completed iteration -> nodes && elapsed so far (main thread only), the
+    // lines of the iteration (best first) -> empty = nothing to report
+    std::function<void(const SearchStatistics &, const std::vector<SearchLine> &)> on_iteration;
+};
+
+// The SearchLine class: See search.fwd.h
+class SearchLine {
+  public:
+    int score = 0; // from the view of the player to move (same units as SearchEngine::MATE_SCORE)
+    int depth = 0; // iteration it was found in
+    std::vector<game::Move> moves; // root move first, then the rest of its principal variation
+};
+
+// The SearchLimits class: See search.fwd.h
+// Unset (0) limits fall back to the defaults -> the player's game clock (TimeManager::DEFAULT_CLOCK_IN_SECONDS)
+// && the engine's own budget (SearchConfig::max_depth for alpha-beta, MCTS::NUM_SIMULATIONS_PER_THREAD for mcts)
+// The engine's own budget only applies if nothing else bounds the search (ie no node count, movetime or clock)
+class SearchLimits {
+  public:
+    long nodes = 0; // alpha-beta -> nodes of the main thread (deterministic if single threaded), mcts -> simulations
+                    // deterministic alpha-beta -> nodes of all threads, checked after each iteration
+    int depth = 0;  // in half-moves -> alpha-beta only
+    double movetime = 0.0;                // in seconds -> fixed time per move, the clock is ignored
+    double clock = 0.0, increment = 0.0; // in seconds -> the player's clock at the start of the game
+    bool infinite = false; // no time limit -> only an abort (or the node/depth limits) stops the search
+
+    [[nodiscard]] inline bool hasTimeControl() const { return infinite || movetime > 0.0 || clock > 0.0; }
+};
+
+// The SearchEngine class: See search.fwd.h
+// Everything the search touches per node (move lists, move scores, killers, history, pv) lives in the
+// SearchThread stacks, which are allocated once in the constructor && reused for every search
+// Threads only share the transposition table, the stop flag && the clock (polled by the main thread)
+// A deterministic search shares no table -> see SearchConfig::deterministic && splitRootSearch(...)
+class SearchEngine {
+  public:
+    SearchEngine() = delete;
+    SearchEngine(const SearchEngine &se) = delete;
+    SearchEngine &operator=(const SearchEngine &se) = delete;
+
+    explicit SearchEngine(const SearchConfig &config);
+    ~SearchEngine();
+
+    // best move for color, within limits && the budget of time_manager (startMove(limits) must already be called)
+    // is_aborted is polled w/ the clock -> true stops the search (ie the move was undone)
+    // no legal move -> game::Move(-1, -1, -1, -1, NONE), an empty principal variation && a single line scored
+    // 0 (stalemate) or -MATE_SCORE (checkmate)
+    game::Move search(game::Board *board, piece::PieceColor color, const SearchLimits &limits,
+                      TimeManager *time_manager, const std::function<bool()> &is_aborted);
+
+    [[nodiscard]] inline const SearchConfig &config() const { return _config; }
+    void setMultiPV(int num_lines); // for the next search -> at least 1
+
+    // stats of the last search, summed over all threads
+    [[nodiscard]] inline const SearchStatistics &lastSearchStatistics() const { return _statistics; }
+    [[nodiscard]] inline long lastSearchNodes() const { return _statistics.nodes; }
+    [[nodiscard]] inline double lastSearchNPS() const { return _statistics.nps(); }
+    // best line found by the last completed iteration, starting w/ the move played
+    [[nodiscard]] inline const std::vector<game::Move> &principalVariation() const { return _principal_variation; }
+    // the config.multi_pv best root moves of the last completed iteration, best first (fewer if there aren't as many)
+    [[nodiscard]] inline const std::vector<SearchLine> &lastSearchLines() const { return _lines; }
+
+    // evaluators -> material only (minimax) && material + piece placement (alpha-beta)
+    static int materialScore(game::Board *board, piece::PieceColor color);
+    static int positionalScore(game::Board *board, piece::PieceColor color);
+
+    static const int MATE_SCORE = 100000; // - plies to mate (from the root) -> sooner mates score higher
+    static const int MATE_BOUND = MATE_SCORE - 1000; // beyond -> a mate
+    static const int TABLEBASE_WIN_SCORE = MATE_SCORE / 2; // - plies to mate -> below real mates, above any eval
+    static const int TABLEBASE_BOUND = TABLEBASE_WIN_SCORE - 1000; // beyond (but not past MATE_BOUND) -> a table win
+
+  private:
+    static const int MAX_PLY = 64;
+    static const int MAX_MOVES = 256; // reserved per ply -> no legal position has more moves than this
+
+    class Frame {
+      public:
+        std::vector<game::Move> moves;
+        std::vector<int> scores;
+        std::size_t evaluated = 0; // moves[0...evaluated) were looked at by evaluateChildren(...)
+    };
+
+    // search state owned by one thread -> thread 0 is the main thread, the rest are Lazy SMP helpers
+    // helpers search the same root (staggered depths) only to fill the shared transposition table
+    class SearchThread {
+      public:
+        int id;
+        game::Board *board;
+        TranspositionTable *table; // the shared one (nullptr if !config.transposition_table) or, if deterministic, its own
+        PawnTable *pawn_table; // nullptr if !config.pawn_structure
+        SearchStatistics statistics; // counters only, see SearchStatistics::merge(...)
+
+        Frame stack[MAX_PLY];
+        std::vector<game::Move> root_moves;
+
+        // move ordering: hash move, then captures/promotions (MVV-LVA), then killers, then quiet moves by history
+        uint16_t killers[MAX_PLY][2]; // last 2 quiet moves that caused a cutoff at each ply
+        int history[2][64 * 64];      // [color][from * 64 + to] -> how often a quiet move caused a cutoff
+
+        // triangular pv table -> pv[ply] holds the best line from ply on (packed moves, up to pv_length[ply])
+        uint16_t pv[MAX_PLY][MAX_PLY];
+        int pv_length[MAX_PLY];
+
+        // config.network only -> scores (white's view) by board hash, empty otherwise
+        // a direct mapped cache, just big enough for the batches evaluateChildren(...) sends ahead of the search
+        std::vector<uint64_t> evaluation_keys;
+        std::vector<int> evaluation_scores;
+        std::vector<uint64_t> batch_keys;
+        std::vector<double> network_inputs, network_outputs, network_scratch;
+    };
+
+    SearchConfig _config;
+    TranspositionTable *_table; // kept between searches -> positions from earlier moves are reused
+    std::vector<SearchThread *> _threads;
+
+    piece::PieceColor _root_color{};
+    TimeManager *_time_manager;
+    const std::function<bool()> *_is_aborted;
+    long _max_nodes; // of the main thread -> 0 = no limit
+    std::atomic_bool _is_time_up; // also tells the helper threads to stop
+    std::vector<int> _split_scores; // [root move] -> null window score from splitSearch(...)
+
+    // deterministic split -> the workers live for the whole search && wait here between splits
+    // the main thread sets the split, bumps _split_generation && waits for _split_running to drop to 0
+    std::mutex _split_mutex;
+    std::condition_variable _split_started, _split_finished;
+    int _split_generation, _split_running;
+    int _split_depth, _split_alpha;
+    std::size_t _split_first;
+    bool _is_split_over; // search done -> the workers exit
+
+    SearchStatistics _statistics;
+    std::vector<game::Move> _principal_variation;
+    std::vector<SearchLine> _lines;
+
+    // one iteration at the root over root_moves[first...last) -> returns the score of *best (root_moves[first] goes
+    // first), fails low/high like any other node if the (aspiration) window is too narrow
+    int rootSearch(SearchThread &thread, int depth, int alpha, int beta, std::size_t first, game::Move *best,
+                   std::size_t last = SIZE_MAX);
+    // negamax -> scores are from the view of the player to move (color)
+    int search(SearchThread &thread, int depth, int ply, int alpha, int beta, piece::PieceColor color,
+               bool allow_null_move = true);
+    // captures/promotions only (all evasions when in check) -> stable scores at the horizon
+    int quiescenceSearch(SearchThread &thread, int ply, int alpha, int beta, piece::PieceColor color);
+    static void helperSearch(SearchEngine *engine, SearchThread *thread, std::atomic_int &finished_count);
+    // deterministic rootSearch(...) -> the main thread searches root_moves[first] (the eldest brother), then every
+    // thread searches a fixed share of the rest w/ a null window around its score && the main thread searches the
+    // moves that fail high again, in order -> nothing any thread does depends on how far the others have got
+    int splitRootSearch(int depth, int alpha, int beta, std::size_t first, game::Move *best);
+    static void splitWorker(SearchEngine *engine, SearchThread *thread, std::atomic_int &finished_count);
+    static void splitSearch(SearchEngine *engine, SearchThread *thread, int depth, int alpha, std::size_t first);
+    [[nodiscard]] long searchedNodes() const; // so far -> main thread only, all threads if deterministic
+    int evaluate(SearchThread &thread, piece::PieceColor color); // config.evaluator (or network) + pawn structure
+    int networkScore(SearchThread &thread, piece::PieceColor color);
+    // config.network only -> the positions after moves[first...] of the node at ply (up to config.network_batch_size
+    // of them that is_searched accepts) go through the network together, so their own evaluate(...) calls are hits
+    void evaluateChildren(SearchThread &thread, int ply, std::size_t first,
+                          const std::function<bool(const game::Move &)> &is_searched);
+    void storeEvaluation(SearchThread &thread, uint64_t key, double output);
+
+    // thread 0 checks _max_nodes at every node && polls the clock every CLOCK_CHECK_INTERVAL nodes
+    void countNode(SearchThread &thread);
+    void generateMoves(SearchThread &thread, int ply, piece::PieceColor color);
+    void scoreMoves(SearchThread &thread, int ply, uint16_t hash_move, piece::PieceColor color);
+    void pickNextMove(SearchThread &thread, int ply, std::size_t index);
+    static void updatePV(SearchThread &thread, int ply, const game::Move &move); // move + the child's pv
+    static void updateQuietCutoff(SearchThread &thread, const game::Move &move, int depth, int ply,
+                                  piece::PieceColor color);
+
+    static bool isQuiet(game::Board *board, const game::Move &move);
+    // material a capture/promotion wins at most -> used for delta pruning in quiescence search
+    static int captureGain(game::Board *board, const game::Move &move);
+    static bool hasNonPawnMaterial(game::Board *board, piece::PieceColor color); // null move zugzwang guard
+    // score of the side to move from the endgame tables -> false if the position isn't in them
+    bool probeTablebases(SearchThread &thread, int ply, piece::PieceColor color, int *score);
+
+    static const int CLOCK_CHECK_INTERVAL = 16;
+    static const int DELTA_MARGIN = 2; // slack for positional terms when delta pruning (in pawns)
+    static const int QUEEN_PROMOTION_GAIN = 9 + 8; // largest captureGain(...) possible -> takes a queen while promoting
+    static const int NULL_MOVE_MIN_DEPTH = 3;
+    static const int NULL_MOVE_REDUCTION = 2; // R -> +1 for depth > 6
+    static const int LMR_MIN_DEPTH = 3;
+    static const int LMR_MIN_MOVE_INDEX = 3; // hash move, best capture, killer... get searched at full depth
+    static const int FUTILITY_MARGIN = 3;    // in pawns (same units as the evaluator)
+    static const int ASPIRATION_MIN_DEPTH = 3; // earlier iterations are too unstable to center a window on
+    static const int ASPIRATION_WINDOW = 1;
+    static const int EVALUATION_CACHE_SIZE = 4096; // power of 2
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_SEARCH_H_
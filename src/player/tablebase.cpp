@@ -0,0 +1,840 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "tablebase.h"
+
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../chess/piece.h"
+#include "../chess/game.h"
+#include "../util/thread_util.h"
+#include "../util/assert_util.h"
+
+namespace {
+
+// piece kinds in material string order
+enum Kind {
+  KIND_KING, KIND_QUEEN, KIND_ROOK, KIND_BISHOP, KIND_KNIGHT, KIND_PAWN, NUM_KINDS
+};
+const char KIND_LETTERS[] = "KQRBNP";
+const int KIND_STRENGTH[] = {0, 9, 5, 3, 3, 1}; // the stronger side is white in the table
+
+const int KING_STEPS[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+const int KNIGHT_STEPS[8][2] = {{2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1}};
+const int ROOK_DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+const int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+
+const uint8_t UNKNOWN = 255; // only while generating
+const uint8_t NEVER_LOST = 255; // escape count of a position won by leaving the table -> never counted down
+
+typedef int Material[2][NUM_KINDS]; // piece counts per side (0 -> white in the table) && kind
+
+inline int rowOf(int square) { return square >> 3; }
+inline int columnOf(int square) { return square & 7; }
+inline bool isOnBoard(int r, int c) { return 0 <= r && r < 8 && 0 <= c && c < 8; }
+
+// lightweight board for generating && probing -> same squares as game::Board (white pawns move towards row 7)
+class Position {
+  public:
+    int count;
+    int square[player::Tablebases::MAX_PIECES];
+    int kind[player::Tablebases::MAX_PIECES];
+    bool white[player::Tablebases::MAX_PIECES];
+    bool white_to_move;
+    int board[64]; // piece index on each square, -1 if empty
+
+    void fillBoard() {
+      std::fill(board, board + 64, -1);
+      for (int i = 0; i < count; ++i)
+        board[square[i]] = i;
+    }
+
+    void remove(int i) {
+      for (int j = i; j + 1 < count; ++j) {
+        square[j] = square[j + 1];
+        kind[j] = kind[j + 1];
+        white[j] = white[j + 1];
+      }
+      --count;
+      fillBoard();
+    }
+
+    [[nodiscard]] int kingSquare(bool is_white) const {
+      for (int i = 0; i < count; ++i)
+        if (kind[i] == KIND_KING && white[i] == is_white)
+          return square[i];
+      return -1;
+    }
+};
+
+bool attacks(const Position &pos, int i, int target) {
+  int from = pos.square[i];
+  int dr = rowOf(target) - rowOf(from), dc = columnOf(target) - columnOf(from);
+  if (dr == 0 && dc == 0)
+    return false;
+
+  switch (pos.kind[i]) {
+    case KIND_KING:
+      return std::abs(dr) <= 1 && std::abs(dc) <= 1;
+    case KIND_KNIGHT:
+      return std::abs(dr * dc) == 2;
+    case KIND_PAWN:
+      return dr == (pos.white[i] ? 1: -1) && std::abs(dc) == 1;
+    default:
+      break;
+  }
+
+  bool straight = dr == 0 || dc == 0, diagonal = std::abs(dr) == std::abs(dc);
+  if ((pos.kind[i] == KIND_ROOK && !straight) || (pos.kind[i] == KIND_BISHOP && !diagonal) || (!straight && !diagonal))
+    return false;
+
+  int step_r = (dr > 0) - (dr < 0), step_c = (dc > 0) - (dc < 0);
+  for (int r = rowOf(from) + step_r, c = columnOf(from) + step_c; r * 8 + c != target; r += step_r, c += step_c)
+    if (pos.board[r * 8 + c] >= 0)
+      return false;
+  return true;
+}
+
+bool inCheck(const Position &pos, bool is_white) {
+  int king = pos.kingSquare(is_white);
+  for (int i = 0; i < pos.count; ++i)
+    if (pos.white[i] != is_white && attacks(pos, i, king))
+      return true;
+  return false;
+}
+
+// fn(child, is_in_table) for every legal move -> captures && promotions change the material (leave the table)
+template<class Fn>
+void forEachMove(const Position &pos, Fn &&fn) {
+  bool mover = pos.white_to_move;
+  for (int i = 0; i < pos.count; ++i) {
+    if (pos.white[i] != mover)
+      continue;
+
+    int from = pos.square[i], r = rowOf(from), c = columnOf(from);
+    auto canLand = [&](int to) -> bool { // empty, or an enemy piece other than the king
+      int target = pos.board[to];
+      return target < 0 || (pos.white[target] != mover && pos.kind[target] != KIND_KING);
+    };
+    auto play = [&](int to, int promotion) -> void {
+      int target = pos.board[to];
+      Position child = pos;
+      child.square[i] = to;
+      if (promotion >= 0)
+        child.kind[i] = promotion;
+      child.white_to_move = !mover;
+      if (target >= 0)
+        child.remove(target);
+      else
+        child.fillBoard();
+
+      if (!inCheck(child, mover))
+        fn(child, target < 0 && promotion < 0);
+    };
+    auto slide = [&](const int (*directions)[2]) -> void {
+      for (int d = 0; d < 4; ++d)
+        for (int tr = r + directions[d][0], tc = c + directions[d][1]; isOnBoard(tr, tc);
+             tr += directions[d][0], tc += directions[d][1]) {
+          if (canLand(tr * 8 + tc))
+            play(tr * 8 + tc, -1);
+          if (pos.board[tr * 8 + tc] >= 0)
+            break;
+        }
+    };
+
+    switch (pos.kind[i]) {
+      case KIND_KING:
+      case KIND_KNIGHT: {
+        const int (*steps)[2] = pos.kind[i] == KIND_KING ? KING_STEPS: KNIGHT_STEPS;
+        for (int s = 0; s < 8; ++s)
+          if (isOnBoard(r + steps[s][0], c + steps[s][1]) && canLand((r + steps[s][0]) * 8 + c + steps[s][1]))
+            play((r + steps[s][0]) * 8 + c + steps[s][1], -1);
+        break;
+      }
+      case KIND_QUEEN:
+        slide(ROOK_DIRECTIONS);
+        slide(BISHOP_DIRECTIONS);
+        break;
+      case KIND_ROOK:
+        slide(ROOK_DIRECTIONS);
+        break;
+      case KIND_BISHOP:
+        slide(BISHOP_DIRECTIONS);
+        break;
+      case KIND_PAWN: {
+        int direction = mover ? 1: -1, last_row = mover ? 7: 0, start_row = mover ? 1: 6;
+        auto advance = [&](int to) -> void {
+          if (rowOf(to) == last_row)
+            for (int promotion = KIND_QUEEN; promotion <= KIND_KNIGHT; ++promotion)
+              play(to, promotion);
+          else
+            play(to, -1);
+        };
+
+        int one = (r + direction) * 8 + c;
+        if (pos.board[one] < 0) {
+          advance(one);
+          if (r == start_row && pos.board[one + direction * 8] < 0)
+            play(one + direction * 8, -1);
+        }
+        for (int dc = -1; dc <= 1; dc += 2) {
+          int to = one + dc;
+          if (isOnBoard(r + direction, c + dc) && pos.board[to] >= 0 && canLand(to))
+            advance(to);
+        }
+        break;
+      }
+      default: FATAL_ASSERT
+    }
+  }
+}
+
+// fn(parent) for every position that reaches pos by a move that stays in the table (no capture/promotion)
+template<class Fn>
+void forEachUnmove(const Position &pos, Fn &&fn) {
+  bool mover = !pos.white_to_move; // the side that just moved
+  for (int i = 0; i < pos.count; ++i) {
+    if (pos.white[i] != mover)
+      continue;
+
+    int to = pos.square[i], r = rowOf(to), c = columnOf(to);
+    auto unplay = [&](int from) -> void {
+      Position parent = pos;
+      parent.square[i] = from;
+      parent.white_to_move = mover;
+      parent.fillBoard();
+      if (!inCheck(parent, !mover)) // the side that didn't move can't have been left in check
+        fn(parent);
+    };
+    auto slide = [&](const int (*directions)[2]) -> void {
+      for (int d = 0; d < 4; ++d)
+        for (int fr = r + directions[d][0], fc = c + directions[d][1];
+             isOnBoard(fr, fc) && pos.board[fr * 8 + fc] < 0; fr += directions[d][0], fc += directions[d][1])
+          unplay(fr * 8 + fc);
+    };
+
+    switch (pos.kind[i]) {
+      case KIND_KING:
+      case KIND_KNIGHT: {
+        const int (*steps)[2] = pos.kind[i] == KIND_KING ? KING_STEPS: KNIGHT_STEPS;
+        for (int s = 0; s < 8; ++s)
+          if (isOnBoard(r + steps[s][0], c + steps[s][1]) && pos.board[(r + steps[s][0]) * 8 + c + steps[s][1]] < 0)
+            unplay((r + steps[s][0]) * 8 + c + steps[s][1]);
+        break;
+      }
+      case KIND_QUEEN:
+        slide(ROOK_DIRECTIONS);
+        slide(BISHOP_DIRECTIONS);
+        break;
+      case KIND_ROOK:
+        slide(ROOK_DIRECTIONS);
+        break;
+      case KIND_BISHOP:
+        slide(BISHOP_DIRECTIONS);
+        break;
+      case KIND_PAWN: {
+        int direction = mover ? 1: -1, first_row = mover ? 0: 7, double_push_row = mover ? 3: 4;
+        int back = to - direction * 8;
+        if (rowOf(back) != first_row && pos.board[back] < 0) {
+          unplay(back);
+          if (r == double_push_row && pos.board[back - direction * 8] < 0)
+            unplay(back - direction * 8);
+        }
+        break;
+      }
+      default: FATAL_ASSERT
+    }
+  }
+}
+
+// "KRvK" -> counts (the side before the 'v' is white) -> false if malformed
+bool parseMaterial(const std::string &material, Material counts) {
+  std::size_t separator = material.find('v');
+  if (separator == std::string::npos)
+    return false;
+
+  int total = 0;
+  for (int side = 0; side < 2; ++side) {
+    std::fill(counts[side], counts[side] + NUM_KINDS, 0);
+    std::string letters = side == 0 ? material.substr(0, separator): material.substr(separator + 1);
+    for (char letter : letters) {
+      const char *kind = std::strchr(KIND_LETTERS, letter);
+      if (letter == '\0' || kind == nullptr)
+        return false;
+      ++counts[side][kind - KIND_LETTERS];
+      ++total;
+    }
+    if (counts[side][KIND_KING] != 1)
+      return false;
+  }
+  return total <= player::Tablebases::MAX_PIECES;
+}
+
+std::string sideName(const int counts[NUM_KINDS]) {
+  std::string name;
+  for (int kind = 0; kind < NUM_KINDS; ++kind)
+    name.append(counts[kind], KIND_LETTERS[kind]);
+  return name;
+}
+
+int sideStrength(const int counts[NUM_KINDS]) {
+  int strength = 0;
+  for (int kind = 0; kind < NUM_KINDS; ++kind)
+    strength += counts[kind] * KIND_STRENGTH[kind];
+  return strength;
+}
+
+// name of the table holding this material -> *flip iff black is the table's white
+std::string materialName(const Material counts, bool *flip) {
+  std::string white = sideName(counts[0]), black = sideName(counts[1]);
+  int white_strength = sideStrength(counts[0]), black_strength = sideStrength(counts[1]);
+  *flip = white_strength < black_strength || (white_strength == black_strength && white < black);
+  return *flip ? black + "v" + white: white + "v" + black;
+}
+
+// no mate is possible at all -> no table needed
+bool isTrivialDraw(const Material counts) {
+  int minors = 0;
+  for (int side = 0; side < 2; ++side) {
+    if (counts[side][KIND_QUEEN] + counts[side][KIND_ROOK] + counts[side][KIND_PAWN] > 0)
+      return false;
+    minors += counts[side][KIND_BISHOP] + counts[side][KIND_KNIGHT];
+  }
+  return minors <= 1;
+}
+
+// pieces are already in table order (see player::Tablebases)
+uint64_t indexOf(const Position &pos) {
+  uint64_t index = 0, multiplier = 1;
+  for (int i = 0; i < pos.count; ++i) {
+    index += (uint64_t) pos.square[i] * multiplier;
+    multiplier *= 64;
+  }
+  return pos.white_to_move ? index: index + multiplier;
+}
+
+// table order: white's pieces, then black's, each as KQRBNP -> false if the position is ILLEGAL
+bool decode(const Material counts, uint64_t index, Position *pos) {
+  pos->count = 0;
+  for (int side = 0; side < 2; ++side)
+    for (int kind = 0; kind < NUM_KINDS; ++kind)
+      for (int k = 0; k < counts[side][kind]; ++k) {
+        int i = pos->count++;
+        pos->square[i] = (int) (index % 64);
+        pos->kind[i] = kind;
+        pos->white[i] = side == 0;
+        index /= 64;
+      }
+  pos->white_to_move = index == 0;
+
+  std::fill(pos->board, pos->board + 64, -1);
+  for (int i = 0; i < pos->count; ++i) {
+    if (pos->board[pos->square[i]] >= 0)
+      return false;
+    if (pos->kind[i] == KIND_PAWN && (rowOf(pos->square[i]) == 0 || rowOf(pos->square[i]) == 7))
+      return false;
+    pos->board[pos->square[i]] = i;
+  }
+  return !inCheck(*pos, !pos->white_to_move);
+}
+
+// value of any position w/ a table (or no mate possible) -> ILLEGAL if its table isn't loaded
+uint8_t lookup(const player::Tablebases &tables, const Position &pos) {
+  Material counts = {};
+  for (int i = 0; i < pos.count; ++i)
+    ++counts[pos.white[i] ? 0: 1][pos.kind[i]];
+  if (isTrivialDraw(counts))
+    return player::Tablebases::DRAW_VALUE;
+
+  bool flip;
+  const player::EndgameTable *table = tables.table(materialName(counts, &flip));
+  if (table == nullptr)
+    return player::Tablebases::ILLEGAL;
+
+  // reorder into table order (mirrored if colors are swapped)
+  Position ordered{};
+  for (int side = 0; side < 2; ++side)
+    for (int kind = 0; kind < NUM_KINDS; ++kind)
+      for (int i = 0; i < pos.count; ++i)
+        if (pos.kind[i] == kind && pos.white[i] == ((side == 0) != flip)) {
+          int j = ordered.count++;
+          ordered.square[j] = flip ? pos.square[i] ^ 56: pos.square[i];
+        }
+  ordered.white_to_move = pos.white_to_move != flip;
+  return table->value(indexOf(ordered));
+}
+
+// runs fn(0), ..., fn(num_threads - 1) on their own threads (0 on the caller's) && returns once all are done
+template<class Fn>
+void runThreads(int num_threads, const Fn &fn) {
+  std::atomic_int finished_count{0};
+  for (int t = 1; t < num_threads; ++t)
+    thread::create([&fn, &finished_count, t] {
+      fn(t);
+      ++finished_count;
+    });
+  fn(0);
+  thread::wait_for([&] { return finished_count >= num_threads - 1; });
+}
+
+}
+
+// EndgameTable class
+const char player::EndgameTable::MAGIC[8] = {'C', 'A', 'I', 'T', 'B', '0', '0', '1'};
+
+player::EndgameTable::EndgameTable(const std::string &file_path) {
+  _mapping = nullptr;
+  _mapping_size = 0;
+  _values = nullptr;
+  _piece_count = 0;
+  _max_distance = 0;
+  _size = 0;
+
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t) sizeof(Header)) {
+    void *mapping = mmap(nullptr, (std::size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      _mapping = mapping;
+      _mapping_size = (std::size_t) file_stat.st_size;
+    }
+  }
+  close(fd); // the mapping stays valid w/o the descriptor
+
+  if (_mapping == nullptr)
+    return;
+
+  const auto *header = (const Header *) _mapping;
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      std::memchr(header->material, '\0', sizeof(header->material)) == nullptr ||
+      sizeof(Header) + header->size != _mapping_size) {
+    DEBUG_ASSERT // -> not a table file (or a truncated one)
+    munmap(_mapping, _mapping_size);
+    _mapping = nullptr;
+    _mapping_size = 0;
+    return;
+  }
+
+  _values = (const uint8_t *) _mapping + sizeof(Header);
+  _material = header->material;
+  _piece_count = (int) header->piece_count;
+  _max_distance = (int) header->max_distance;
+  _size = header->size;
+}
+
+player::EndgameTable::~EndgameTable() {
+  if (_mapping != nullptr)
+    munmap(_mapping, _mapping_size);
+}
+
+// Tablebases class
+player::Tablebases *player::Tablebases::LOADED = nullptr;
+
+player::Tablebases::Tablebases(const std::string &directory) {
+  _max_pieces = 0;
+
+  std::error_code error;
+  if (!std::filesystem::is_directory(directory, error))
+    return;
+  for (const auto &file : std::filesystem::directory_iterator(directory, error))
+    if (file.path().extension() == ".tb")
+      add(file.path().string());
+}
+
+player::Tablebases::~Tablebases() {
+  for (auto &it : _tables)
+    delete it.second;
+}
+
+bool player::Tablebases::add(const std::string &file_path) {
+  auto *table = new EndgameTable(file_path);
+
+  Material counts;
+  bool flip;
+  if (!table->isOpen() || !parseMaterial(table->material(), counts) || materialName(counts, &flip) !=
+                                                                          table->material() ||
+      table->size() != (uint64_t) 2 << (6 * table->pieceCount())) {
+    delete table;
+    return false;
+  }
+
+  delete _tables[table->material()]; // replaces an older copy
+  _tables[table->material()] = table;
+  _max_pieces = std::max(_max_pieces, table->pieceCount());
+  return true;
+}
+
+const player::EndgameTable *player::Tablebases::table(const std::string &material) const {
+  auto it = _tables.find(material);
+  return it != _tables.end() ? it->second: nullptr;
+}
+
+bool player::Tablebases::probe(const game::Board *board, piece::PieceColor color, Result *result) const {
+  if (board->pieceCount(piece::PieceColor::NONE) > _max_pieces)
+    return false;
+
+  Position pos{};
+  bool has_unmoved_king[2] = {false, false}, has_unmoved_rook[2] = {false, false};
+  int moved2x_pawn = -1;
+  board->forEachPiece([&](piece::Piece *piece, int r, int c) -> void {
+    int i = pos.count++;
+    pos.square[i] = r * 8 + c;
+    pos.white[i] = piece->color().isWhite();
+    switch (piece->type()) {
+      case piece::PieceType::KING:
+        pos.kind[i] = KIND_KING;
+        has_unmoved_king[pos.white[i]] |= !static_cast<piece::King *>(piece)->moved();
+        break;
+      case piece::PieceType::QUEEN:
+        pos.kind[i] = KIND_QUEEN;
+        break;
+      case piece::PieceType::ROOK:
+        pos.kind[i] = KIND_ROOK;
+        has_unmoved_rook[pos.white[i]] |= !static_cast<piece::Rook *>(piece)->moved();
+        break;
+      case piece::PieceType::BISHOP:
+        pos.kind[i] = KIND_BISHOP;
+        break;
+      case piece::PieceType::KNIGHT:
+        pos.kind[i] = KIND_KNIGHT;
+        break;
+      case piece::PieceType::PAWN:
+        pos.kind[i] = KIND_PAWN;
+        if (static_cast<piece::Pawn *>(piece)->moved2x() && pos.white[i] != color.isWhite())
+          moved2x_pawn = i;
+        break;
+      default: FATAL_ASSERT
+    }
+  });
+  pos.white_to_move = color.isWhite();
+  pos.fillBoard();
+
+  // castling
+  for (int side = 0; side < 2; ++side)
+    if (has_unmoved_king[side] && has_unmoved_rook[side])
+      return false;
+  // en passant -> a pawn of the side to move right next to the one that just moved 2 squares
+  if (moved2x_pawn >= 0)
+    for (int dc = -1; dc <= 1; dc += 2) {
+      int r = rowOf(pos.square[moved2x_pawn]), c = columnOf(pos.square[moved2x_pawn]) + dc;
+      int neighbor = isOnBoard(r, c) ? pos.board[r * 8 + c]: -1;
+      if (neighbor >= 0 && pos.kind[neighbor] == KIND_PAWN && pos.white[neighbor] == pos.white_to_move)
+        return false;
+    }
+
+  uint8_t value = lookup(*this, pos);
+  if (value == ILLEGAL)
+    return false;
+
+  if (value == DRAW_VALUE)
+    *result = {DRAW, 0};
+  else
+    *result = {value % 2 == 0 ? LOSS: WIN, value};
+  return true;
+}
+
+bool player::Tablebases::bestMove(const game::Board *board, piece::PieceColor color, game::Move *move,
+                                  Result *result) const {
+  Result root{};
+  if (!probe(board, color, &root))
+    return false;
+
+  game::Board *clone = board->clone();
+  clone->set_pawn_upgrade_type(piece::PieceType::QUEEN);
+  std::vector<game::Move> moves;
+  clone->getCachedMoves(color, &moves);
+
+  // the child's result is the opponent's -> fastest win, then any draw, then slowest loss
+  int best_rank = INT_MIN;
+  Result best{};
+  for (const game::Move &candidate : moves) {
+    clone->doMove(candidate, nullptr);
+    Result child{};
+    bool is_known = probe(clone, !color, &child);
+    clone->undoMove(nullptr);
+    if (!is_known)
+      continue;
+
+    int rank = child.outcome == LOSS ? 1000 - child.distance: child.outcome == DRAW ? 0: child.distance - 1000;
+    if (rank > best_rank) {
+      best_rank = rank;
+      *move = candidate;
+      best = child.outcome == DRAW ? Result{DRAW, 0}:
+             Result{child.outcome == LOSS ? WIN: LOSS, child.distance + 1};
+    }
+  }
+  delete clone;
+
+  if (best_rank == INT_MIN)
+    return false;
+  if (result != nullptr)
+    *result = best;
+  return true;
+}
+
+// TablebaseGenerator class
+player::TablebaseGenerator::TablebaseGenerator(Tablebases *tables, std::string directory, int num_threads,
+                                               bool print_progress) {
+  _tables = tables;
+  _directory = std::move(directory);
+  _num_threads = std::max(num_threads, 1);
+  _print_progress = print_progress;
+}
+
+player::TablebaseGenerator::~TablebaseGenerator() = default;
+
+bool player::TablebaseGenerator::generate(const std::string &material) {
+  Material counts;
+  if (!parseMaterial(material, counts))
+    return false;
+
+  bool flip;
+  std::string name = materialName(counts, &flip);
+  if (isTrivialDraw(counts) || _tables->table(name) != nullptr)
+    return true;
+
+  // every material a capture or a promotion leads to
+  for (int side = 0; side < 2; ++side)
+    for (int kind = KIND_QUEEN; kind < NUM_KINDS; ++kind) {
+      if (counts[side][kind] == 0)
+        continue;
+
+      Material captured;
+      std::memcpy(captured, counts, sizeof(Material));
+      --captured[side][kind];
+      if (!generate(materialName(captured, &flip)))
+        return false;
+
+      if (kind == KIND_PAWN)
+        for (int promotion = KIND_QUEEN; promotion <= KIND_KNIGHT; ++promotion) {
+          Material promoted;
+          std::memcpy(promoted, counts, sizeof(Material));
+          --promoted[side][KIND_PAWN];
+          ++promoted[side][promotion];
+          if (!generate(materialName(promoted, &flip)))
+            return false;
+        }
+    }
+
+  return generateTable(name);
+}
+
+bool player::TablebaseGenerator::generateTable(const std::string &material) {
+  auto start_time = std::chrono::steady_clock::now();
+
+  Material counts;
+  parseMaterial(material, counts);
+  int piece_count = 0;
+  for (auto &side : counts)
+    for (int count : side)
+      piece_count += count;
+  uint64_t size = (uint64_t) 2 << (6 * piece_count);
+
+  auto *values = new std::atomic<uint8_t>[size];
+  auto *escapes = new std::atomic<uint8_t>[size];       // moves not (yet) known to lose
+  auto *loss_distances = new std::atomic<uint8_t>[size]; // longest of the moves known to lose
+
+  // buckets[thread][distance] -> positions to resolve once that distance is reached
+  // a position resolved at an odd distance is won by the side to move, at an even one it is lost
+  std::vector<std::vector<std::vector<uint32_t>>> buckets(
+    _num_threads, std::vector<std::vector<uint32_t>>(Tablebases::MAX_DISTANCE + 1));
+
+  // forward pass -> mates, stalemates && everything decided by leaving the table
+  runThreads(_num_threads, [&](int t) -> void {
+    Position pos{};
+    for (uint64_t index = size * t / _num_threads; index < size * (t + 1) / _num_threads; ++index) {
+      escapes[index].store(0, std::memory_order_relaxed);
+      loss_distances[index].store(0, std::memory_order_relaxed);
+      if (!decode(counts, index, &pos)) {
+        values[index].store(Tablebases::ILLEGAL, std::memory_order_relaxed);
+        continue;
+      }
+      values[index].store(UNKNOWN, std::memory_order_relaxed);
+
+      bool has_move = false;
+      int escape_count = 0, win_distance = INT_MAX, longest_loss = 0;
+      forEachMove(pos, [&](const Position &child, bool is_in_table) -> void {
+        has_move = true;
+        if (is_in_table) {
+          ++escape_count;
+          return;
+        }
+
+        uint8_t value = lookup(*_tables, child);
+        if (value > Tablebases::MAX_DISTANCE)
+          ++escape_count; // draw
+        else if (value % 2 == 0)
+          win_distance = std::min(win_distance, value + 1);
+        else
+          longest_loss = std::max(longest_loss, value + 1);
+      });
+
+      if (!has_move) {
+        if (inCheck(pos, pos.white_to_move))
+          buckets[t][0].push_back((uint32_t) index);
+        else
+          values[index].store(Tablebases::DRAW_VALUE, std::memory_order_relaxed);
+        continue;
+      }
+
+      // a winning exit (capture / promotion) -> won in win_distance at the latest && never lost,
+      // even if every other move runs into a loss
+      loss_distances[index].store((uint8_t) std::min(longest_loss, (int) UNKNOWN), std::memory_order_relaxed);
+      if (win_distance <= Tablebases::MAX_DISTANCE) {
+        escapes[index].store(NEVER_LOST, std::memory_order_relaxed);
+        buckets[t][win_distance].push_back((uint32_t) index);
+        continue;
+      }
+
+      escapes[index].store((uint8_t) escape_count, std::memory_order_relaxed);
+      if (escape_count == 0 && longest_loss <= Tablebases::MAX_DISTANCE)
+        buckets[t][longest_loss].push_back((uint32_t) index);
+    }
+  });
+
+  // backward passes -> one distance at a time, so every position gets its shortest (or longest, if lost) mate
+  int max_distance = 0;
+  std::vector<std::vector<uint32_t>> resolved(_num_threads);
+  for (int distance = 0; distance <= Tablebases::MAX_DISTANCE; ++distance) {
+    std::vector<uint32_t> level;
+    bool has_pending = false;
+    for (auto &thread_buckets : buckets) {
+      level.insert(level.end(), thread_buckets[distance].begin(), thread_buckets[distance].end());
+      std::vector<uint32_t>().swap(thread_buckets[distance]);
+      for (int d = distance + 1; d <= Tablebases::MAX_DISTANCE; ++d)
+        has_pending |= !thread_buckets[d].empty();
+    }
+    if (level.empty()) {
+      if (!has_pending)
+        break;
+      continue;
+    }
+
+    // a position can be queued more than once (ie lost through several moves) -> only the first one counts
+    runThreads(_num_threads, [&](int t) -> void {
+      resolved[t].clear();
+      for (std::size_t k = level.size() * t / _num_threads; k < level.size() * (t + 1) / _num_threads; ++k) {
+        uint8_t expected = UNKNOWN;
+        if (values[level[k]].compare_exchange_strong(expected, (uint8_t) distance))
+          resolved[t].push_back(level[k]);
+      }
+    });
+
+    runThreads(_num_threads, [&](int t) -> void {
+      Position pos{};
+      for (uint32_t index : resolved[t]) {
+        decode(counts, index, &pos);
+        forEachUnmove(pos, [&](const Position &parent) -> void {
+          uint64_t parent_index = indexOf(parent);
+          if (values[parent_index].load() != UNKNOWN)
+            return;
+
+          if (distance % 2 == 0) { // lost here -> the parent wins by moving into it
+            if (distance + 1 <= Tablebases::MAX_DISTANCE)
+              buckets[t][distance + 1].push_back((uint32_t) parent_index);
+            return;
+          }
+
+          // won here -> one escape less for the parent, which is lost once it has none left
+          if (escapes[parent_index].load() == NEVER_LOST)
+            return;
+          uint8_t longest = loss_distances[parent_index].load();
+          while (longest < distance + 1 && !loss_distances[parent_index].compare_exchange_weak(longest, distance + 1));
+          if (escapes[parent_index].fetch_sub(1) == 1) {
+            int loss_distance = std::max((int) loss_distances[parent_index].load(), distance + 1);
+            if (loss_distance <= Tablebases::MAX_DISTANCE)
+              buckets[t][loss_distance].push_back((uint32_t) parent_index);
+          }
+        });
+      }
+    });
+
+    for (auto &thread_resolved : resolved)
+      if (!thread_resolved.empty())
+        max_distance = distance;
+  }
+
+  // whatever wasn't resolved can't be forced either way
+  std::vector<uint8_t> bytes(size);
+  for (uint64_t index = 0; index < size; ++index) {
+    uint8_t value = values[index].load(std::memory_order_relaxed);
+    bytes[index] = value == UNKNOWN ? Tablebases::DRAW_VALUE: value;
+  }
+  delete[] values;
+  delete[] escapes;
+  delete[] loss_distances;
+
+  EndgameTable::Header header{};
+  std::memcpy(header.magic, EndgameTable::MAGIC, sizeof(header.magic));
+  std::strncpy(header.material, material.c_str(), sizeof(header.material) - 1);
+  header.piece_count = piece_count;
+  header.max_distance = max_distance;
+  header.size = size;
+
+  std::error_code error;
+  std::filesystem::create_directories(_directory, error);
+  std::string file_path = _directory + "/" + material + ".tb";
+  std::ofstream out_stream(file_path, std::ios::binary | std::ios::trunc);
+  if (!out_stream.is_open()) {
+    DEBUG_ASSERT
+    return false;
+  }
+  out_stream.write((const char *) &header, sizeof(header));
+  out_stream.write((const char *) bytes.data(), (std::streamsize) size);
+  out_stream.close();
+  if (!out_stream || !_tables->add(file_path)) {
+    DEBUG_ASSERT
+    return false;
+  }
+
+  if (_print_progress) {
+    long wins = 0, losses = 0, draws = 0;
+    for (uint8_t value : bytes)
+      if (value == Tablebases::DRAW_VALUE)
+        ++draws;
+      else if (value <= Tablebases::MAX_DISTANCE)
+        ++(value % 2 == 0 ? losses: wins);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << "Tablebase " << material << ": " << wins << " wins, " << draws << " draws, " << losses
+              << " losses (side to move), longest mate " << max_distance << " plies, " << seconds << " s" << std::endl;
+  }
+  return true;
+}
@@ -0,0 +1,159 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_TABLEBASE_H_
+#define CHESS_AI_PLAYER_TABLEBASE_H_
+
+#include "tablebase.fwd.h"
+
+#include <string>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+#include "../chess/piece.fwd.h"
+#include "../chess/game.fwd.h"
+
+namespace player {
+
+// The EndgameTable class: See tablebase.fwd.h
+// File layout -> Header, then one value byte per position index (see Tablebases for both)
+class EndgameTable {
+  public:
+    class Header {
+      public:
+        char magic[8];     // see MAGIC
+        char material[16]; // ie "KBNvK" -> null terminated
+        uint32_t piece_count;
+        uint32_t max_distance; // longest mate in the table, in plies
+        uint64_t size;         // # of positions (== # of value bytes)
+    };
+
+    EndgameTable() = delete;
+    EndgameTable(const EndgameTable &table) = delete;
+    EndgameTable &operator=(const EndgameTable &table) = delete;
+
+    explicit EndgameTable(const std::string &file_path);
+    ~EndgameTable();
+
+    [[nodiscard]] inline bool isOpen() const { return _values != nullptr; }
+    [[nodiscard]] inline const std::string &material() const { return _material; }
+    [[nodiscard]] inline int pieceCount() const { return _piece_count; }
+    [[nodiscard]] inline int maxDistance() const { return _max_distance; }
+    [[nodiscard]] inline uint64_t size() const { return _size; }
+
+    [[nodiscard]] inline uint8_t value(uint64_t index) const { return _values[index]; }
+
+    static const char MAGIC[8];
+
+  private:
+    void *_mapping;
+    std::size_t _mapping_size;
+    const uint8_t *_values; // nullptr if the file couldn't be mapped
+
+    std::string _material;
+    int _piece_count;
+    int _max_distance;
+    uint64_t _size;
+};
+
+// The Tablebases class: See tablebase.fwd.h
+// A table covers one material set, w/ the stronger side as white (the other way around is probed mirrored)
+// Positions are indexed as (side to move != white) * 64^n + sum(square_i * 64^i), where the pieces are ordered
+// like the material string (white first, then black, each as KQRBNP) && square = r * 8 + c
+// Values are the distance to mate in plies (odd -> side to move mates, even -> side to move gets mated), DRAW or
+// ILLEGAL (pieces overlap, pawns on the last rank, side not to move in check)
+// Castling && en passant aren't part of the tables -> positions where either could be played are never probed
+class Tablebases {
+  public:
+    enum Outcome {
+      LOSS, DRAW, WIN // for the side to move
+    };
+
+    class Result {
+      public:
+        Outcome outcome;
+        int distance; // plies to mate (0 for draws)
+    };
+
+    Tablebases() = delete;
+    Tablebases(const Tablebases &tb) = delete;
+    Tablebases &operator=(const Tablebases &tb) = delete;
+
+    explicit Tablebases(const std::string &directory); // loads every *.tb file found in directory
+    ~Tablebases();
+
+    bool add(const std::string &file_path); // false if the file isn't a valid table
+
+    [[nodiscard]] inline std::size_t size() const { return _tables.size(); }
+    [[nodiscard]] inline int maxPieces() const { return _max_pieces; }
+    [[nodiscard]] const EndgameTable *table(const std::string &material) const; // nullptr if not loaded
+
+    // result for the side to move -> false if the position isn't covered (see above)
+    bool probe(const game::Board *board, piece::PieceColor color, Result *result) const;
+    // move that keeps the best result (fastest win, any draw, slowest loss) -> false if the position isn't covered
+    bool bestMove(const game::Board *board, piece::PieceColor color, game::Move *move, Result *result = nullptr) const;
+
+    static Tablebases *LOADED; // probed by the searches && MCTS -> nullptr if no tables
+
+    static const int MAX_PIECES = 5; // kings included
+    static const uint8_t MAX_DISTANCE = 252;
+    static const uint8_t ILLEGAL = 253;
+    static const uint8_t DRAW_VALUE = 254;
+
+  private:
+    std::map<std::string, EndgameTable *> _tables;
+    int _max_pieces;
+};
+
+// The TablebaseGenerator class: See tablebase.fwd.h
+// Retrograde analysis -> every position is generated forward once (mates, stalemates && the results of captures
+// or promotions, which leave the table), then results are pushed back to the positions they came from, one
+// distance at a time, through un-moves. Both passes are split over num_threads threads
+class TablebaseGenerator {
+  public:
+    TablebaseGenerator() = delete;
+    TablebaseGenerator(const TablebaseGenerator &generator) = delete;
+    TablebaseGenerator &operator=(const TablebaseGenerator &generator) = delete;
+
+    // generated tables are written to directory && added to tables
+    TablebaseGenerator(Tablebases *tables, std::string directory, int num_threads = 1, bool print_progress = true);
+    ~TablebaseGenerator();
+
+    // ie "KQvK", "KPvK", "KBNvK" -> tables reached by captures/promotions are generated first (if not loaded)
+    // returns false if the material is invalid or a table couldn't be written
+    bool generate(const std::string &material);
+
+  private:
+    Tablebases *_tables;
+    std::string _directory;
+    int _num_threads;
+    bool _print_progress;
+
+    bool generateTable(const std::string &material); // every table it depends on is already loaded
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_TABLEBASE_H_
@@ -0,0 +1,96 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "time_manager.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "search.h"
+
+double player::TimeManager::DEFAULT_CLOCK_IN_SECONDS = 600.0;
+double player::TimeManager::DEFAULT_INCREMENT_IN_SECONDS = 5.0;
+int player::TimeManager::MOVES_TO_GO = 30;
+
+player::TimeManager::TimeManager(double clock_in_seconds, double increment_in_seconds) {
+  _remaining = clock_in_seconds;
+  _increment = increment_in_seconds;
+
+  _soft_limit = _hard_limit = _optimum = 0.0;
+  _is_stopped = false;
+  _start = std::chrono::steady_clock::now();
+}
+
+void player::TimeManager::startMove() {
+  _start = std::chrono::steady_clock::now();
+  _is_stopped = false;
+
+  // keep a little in reserve so a slow move can't flag the clock
+  double usable = std::max(_remaining - 0.05 * _remaining - 0.1, 0.0);
+  double budget = usable / std::max(MOVES_TO_GO, 1) + 0.75 * _increment;
+  budget = std::max(std::min(budget, usable), 0.05);
+
+  // an iteration usually takes longer than all the ones before it -> don't start one past half the budget
+  _soft_limit = 0.5 * budget;
+  _hard_limit = std::max(std::min(3.0 * budget, 0.5 * usable), budget);
+  _optimum = budget;
+}
+
+void player::TimeManager::startMove(const SearchLimits &limits) {
+  if (limits.infinite || (!limits.hasTimeControl() && (limits.nodes > 0 || limits.depth > 0))) {
+    startInfinite(); // fixed size searches are never cut short by the clock
+  } else if (limits.movetime > 0.0) {
+    _start = std::chrono::steady_clock::now();
+    _is_stopped = false;
+    _soft_limit = _hard_limit = _optimum = limits.movetime;
+  } else {
+    startMove();
+  }
+}
+
+void player::TimeManager::startInfinite() {
+  _start = std::chrono::steady_clock::now();
+  _is_stopped = false;
+  _soft_limit = _hard_limit = _optimum = std::numeric_limits<double>::infinity();
+}
+
+void player::TimeManager::takeOver(const TimeManager &clock) {
+  // budgets are relative to each clock's own start -> shift clock's by how far apart the two were started
+  double offset = elapsed() - clock.elapsed();
+  _optimum = clock._optimum + offset;
+  _hard_limit = clock._hard_limit + offset;
+  _soft_limit = clock._soft_limit + offset;
+}
+
+void player::TimeManager::endMove() {
+  _remaining = std::max(_remaining - elapsed(), 0.0) + _increment;
+}
+
+void player::TimeManager::stop() {
+  _is_stopped = true;
+}
+
+double player::TimeManager::elapsed() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+}
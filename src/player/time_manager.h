@@ -0,0 +1,81 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_TIME_MANAGER_H_
+#define CHESS_AI_PLAYER_TIME_MANAGER_H_
+
+#include "time_manager.fwd.h"
+
+#include <chrono>
+#include <atomic>
+
+#include "search.fwd.h"
+
+namespace player {
+
+// The TimeManager class: See time_manager.fwd.h
+// Each move gets (remaining clock / moves to go + most of the increment) as its budget:
+//   - soft limit: past it, iterative deepening doesn't start another iteration
+//   - hard limit: past it, the search is aborted && the last completed iteration's move is played
+//   - optimum: the budget itself -> where searches that can stop at any point (mcts) stop
+// A SearchLimits movetime replaces the budget, && searches limited only by nodes/depth get no budget at all
+// There is no timer thread -> the search polls hardLimitReached() itself (stop() from any thread ends it the same way)
+// A ponder hit hands the move's budgets to the ponder clock (takeOver) -> the ponder search ends like a normal one
+class TimeManager {
+  public:
+    TimeManager() = delete;
+    TimeManager(const TimeManager &tm) = delete;
+    TimeManager &operator=(const TimeManager &tm) = delete;
+
+    TimeManager(double clock_in_seconds, double increment_in_seconds);
+    ~TimeManager() = default;
+
+    void startMove(); // sets the budgets for this move from the clock
+    void startMove(const SearchLimits &limits); // same, unless limits have their own (movetime, infinite...)
+    void startInfinite(); // no budgets -> only an abort stops the search (ie pondering on the opponent's time)
+    void takeOver(const TimeManager &clock); // this (running) clock gets clock's budgets for the rest of its move
+    void endMove();   // charges the time used to the clock && adds the increment
+    void stop();      // every limit counts as reached until the next startMove() -> ie an early "stop" from the gui
+
+    [[nodiscard]] double elapsed() const; // in seconds, since startMove()
+    [[nodiscard]] inline double remaining() const { return _remaining; }
+
+    [[nodiscard]] inline bool softLimitReached() const { return _is_stopped || elapsed() >= _soft_limit; }
+    [[nodiscard]] inline bool hardLimitReached() const { return _is_stopped || elapsed() >= _hard_limit; }
+    [[nodiscard]] inline bool optimumReached() const { return _is_stopped || elapsed() >= _optimum; }
+
+    static double DEFAULT_CLOCK_IN_SECONDS;
+    static double DEFAULT_INCREMENT_IN_SECONDS;
+    static int MOVES_TO_GO; // moves the remaining clock is assumed to cover
+
+  private:
+    std::chrono::steady_clock::time_point _start;
+    double _remaining, _increment;
+    std::atomic<double> _soft_limit, _hard_limit, _optimum; // takeOver() changes them while a search reads them
+    std::atomic_bool _is_stopped;
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_TIME_MANAGER_H_
@@ -0,0 +1,118 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#include "transposition_table.h"
+
+#include <cstdlib>
+
+#include "search.h"
+#include "../util/assert_util.h"
+
+int player::TranspositionTable::DEFAULT_SIZE_IN_MB = 32;
+
+player::TranspositionTable::TranspositionTable(int size_in_mb) {
+  if (size_in_mb <= 0) {
+    DEBUG_ASSERT
+    size_in_mb = 1;
+  }
+
+  // largest power of 2 that fits in the requested memory
+  std::size_t max_entries = ((std::size_t) size_in_mb << 20U) / sizeof(Slot);
+  _size = 1;
+  while (_size * 2 <= max_entries)
+    _size *= 2;
+
+  _slots = new Slot[_size];
+  _index_mask = _size - 1;
+  clear();
+}
+
+player::TranspositionTable::~TranspositionTable() {
+  delete[] _slots;
+}
+
+// score in the high 32 bits, then move (16), depth (8) and bound + age (8)
+uint64_t player::TranspositionTable::pack(int score, uint16_t move, int depth, uint8_t bound_and_age) {
+  return ((uint64_t) (uint32_t) score << 32U) | ((uint64_t) move << 16U) | ((uint64_t) (uint8_t) depth << 8U) |
+         bound_and_age;
+}
+
+// scores past TABLEBASE_BOUND (mates included) are wins/losses at a distance -> a win found ply plies down is
+// ply plies sooner from where it was found
+int player::TranspositionTable::toStored(int score, int ply) {
+  if (std::abs(score) < SearchEngine::TABLEBASE_BOUND)
+    return score;
+  return score > 0 ? score + ply: score - ply;
+}
+
+int player::TranspositionTable::fromStored(int score, int ply) {
+  if (std::abs(score) < SearchEngine::TABLEBASE_BOUND)
+    return score;
+  return score > 0 ? score - ply: score + ply;
+}
+
+player::TranspositionTable::Entry player::TranspositionTable::unpack(uint64_t key, uint64_t data) {
+  return {key, (int32_t) (uint32_t) (data >> 32U), (uint16_t) (data >> 16U), (int8_t) (uint8_t) (data >> 8U),
+          (uint8_t) data};
+}
+
+bool player::TranspositionTable::probe(uint64_t key, int ply, Entry *entry) const {
+  const Slot &slot = _slots[key & _index_mask];
+  uint64_t data = slot.data.load(std::memory_order_relaxed);
+  if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || (data & 3U) == NONE)
+    return false;
+
+  *entry = unpack(key, data);
+  entry->score = fromStored(entry->score, ply);
+  return true;
+}
+
+void player::TranspositionTable::store(uint64_t key, int depth, int ply, int score, Bound bound, uint16_t move) {
+  Slot &slot = _slots[key & _index_mask];
+  uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+  Entry old = unpack(slot.check.load(std::memory_order_relaxed) ^ old_data, old_data);
+
+  bool same_position = old.key == key;
+  if (!same_position && old.bound() != NONE && old.age() == _age && old.depth > depth)
+    return; // keep deeper results from this search
+
+  if (same_position && move == 0)
+    move = old.move; // don't forget the best move of an earlier search
+
+  uint64_t data = pack(toStored(score, ply), move, depth, (uint8_t) (bound | (_age << 2U)));
+  slot.check.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+void player::TranspositionTable::newSearch() {
+  _age = (_age + 1) & 63U;
+}
+
+void player::TranspositionTable::clear() {
+  for (std::size_t i = 0; i < _size; ++i) {
+    _slots[i].check.store(0, std::memory_order_relaxed);
+    _slots[i].data.store(0, std::memory_order_relaxed);
+  }
+  _age = 0;
+}
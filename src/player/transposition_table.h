@@ -0,0 +1,100 @@
+// ------------------------------------------------------------------------------ //
+// MIT License                                                                    //
+//                                                                                //
+// Copyright (c) 2020 Utkarsh Priyam                                              //
+//                                                                                //
+// Permission is hereby granted, free of charge, to any person obtaining a copy   //
+// of this software and associated documentation files (the "Software"), to deal  //
+// in the Software without restriction, including without limitation the rights   //
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      //
+// copies of the Software, and to permit persons to whom the Software is          //
+// furnished to do so, subject to the following conditions:                       //
+//                                                                                //
+// The above copyright notice and this permission notice shall be included in all //
+// copies or substantial portions of the Software.                                //
+//                                                                                //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     //
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       //
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    //
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         //
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  //
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  //
+// SOFTWARE.                                                                      //
+// ------------------------------------------------------------------------------ //
+
+#ifndef CHESS_AI_PLAYER_TRANSPOSITION_TABLE_H_
+#define CHESS_AI_PLAYER_TRANSPOSITION_TABLE_H_
+
+#include "transposition_table.fwd.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace player {
+
+// The TranspositionTable class: See transposition_table.fwd.h
+// One entry per slot, replaced when the new result is at least as deep or the old one is from an earlier search
+// The table never grows after construction, so memory is bounded by the size given on creation
+// Safe to share between search threads w/o locks: each slot stores key ^ data next to data, so a slot torn by two
+// concurrent writers simply fails the key check on the next probe (and is treated as a miss)
+class TranspositionTable {
+  public:
+    enum Bound {
+      NONE, EXACT, LOWER, UPPER // LOWER -> score is a lower bound (failed high), UPPER -> upper bound (failed low)
+    };
+
+    class Entry {
+      public:
+        uint64_t key;
+        int32_t score;
+        uint16_t move; // see game::Move::pack() -> 0 if no best move is known
+        int8_t depth;
+        uint8_t bound_and_age; // bound in the low 2 bits, search generation in the rest
+
+        [[nodiscard]] inline Bound bound() const { return (Bound) (bound_and_age & 3U); }
+        [[nodiscard]] inline uint8_t age() const { return bound_and_age >> 2U; }
+    };
+
+    TranspositionTable() = delete;
+    TranspositionTable(const TranspositionTable &tt) = delete;
+    TranspositionTable &operator=(const TranspositionTable &tt) = delete;
+
+    explicit TranspositionTable(int size_in_mb);
+    ~TranspositionTable();
+
+    // copies the entry for key into entry -> true iff the position was found
+    // ply -> distance from the root: mate && tablebase scores count plies from the root, but are stored counting
+    // from the position itself, so an entry is right wherever in the tree it's found again
+    bool probe(uint64_t key, int ply, Entry *entry) const;
+    void store(uint64_t key, int depth, int ply, int score, Bound bound, uint16_t move);
+
+    void newSearch(); // entries from earlier searches become preferred replacement targets
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    static int DEFAULT_SIZE_IN_MB;
+
+  private:
+    class Slot {
+      public:
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data; // see pack(...)
+    };
+
+    static int toStored(int score, int ply);   // root-relative -> position-relative (see probe(...))
+    static int fromStored(int score, int ply); // and back
+
+    static uint64_t pack(int score, uint16_t move, int depth, uint8_t bound_and_age);
+    static Entry unpack(uint64_t key, uint64_t data);
+
+    Slot *_slots;
+    std::size_t _size;
+    uint64_t _index_mask;
+    uint8_t _age;
+};
+
+}
+
+#endif // CHESS_AI_PLAYER_TRANSPOSITION_TABLE_H_